@@ -0,0 +1,599 @@
+#include "ai_2048.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "src/core/board_2048.h"
+
+
+#define ROW_COUNT (0x10000) // number of different rows of a board
+#define CHECK_INTERVAL (1024) // positions visited between checks of the clock
+#define MAX_TASKS (4 * 2 * SIZE * SIZE) // most tiles that could be added after the root moves
+#define PARALLEL_DEPTH (3) // shallowest search that is shared between threads
+
+/* weights of the parts of the heuristic score of each row */
+#define LOST_PENALTY (200000.0f) // added to every row, so that losing scores far lower than any live position
+#define EMPTY_WEIGHT (270.0f) // for each empty cell
+#define MERGES_WEIGHT (700.0f) // for each pair of matching tiles
+#define MONOTONICITY_WEIGHT (47.0f) // against tiles that go up and down along the row
+#define SUM_WEIGHT (11.0f) // against big tiles anywhere
+
+
+/**
+ * Remembered value of a position after a move, before a tile is added.
+ *
+ * The table is shared between threads without a lock. The value, generation and depth are packed into one word, and
+ * the position is stored XORed with that word, so an entry torn by two threads writing at once fails to match any
+ * position rather than giving a wrong value.
+ */
+struct Entry {
+  uint64_t key; // the position XORed with the data
+  uint64_t data; // the value's bits, then the generation from bit 32, then the depth from bit 48
+};
+
+
+/**
+ * One tile that could be added after a move at the root, to be searched by any thread.
+ */
+struct Task {
+  Board board; // the position with the tile added
+  double prob; // the chance of the tile being added
+  float value; // set to the expected score of the best move from the position
+};
+
+
+/**
+ * State of a single thread of a search.
+ */
+struct Worker {
+  pthread_t thread;
+  struct Ai *ai; // the search, whose table and tasks are shared by every worker
+  int index; // position in the search's workers (0 for the calling thread)
+  unsigned round; // the last round of tasks seen by this thread
+  long nodes; // number of positions visited by this worker
+};
+
+
+struct Ai {
+  struct Entry *table; // remembered positions, indexed by a hash of the board
+  uint16_t generation; // bumped for each search, so the table never has to be cleared
+
+  long long deadline; // time the search must stop by, in microseconds (0 while it must finish)
+  int is_stopped; // set once the deadline has passed (read and written atomically)
+  long nodes; // number of positions visited
+  int depth; // depth of the deepest search that finished
+
+  /* the tiles being searched, shared by every worker */
+  struct Task *tasks;
+  int num_tasks;
+  int next_task; // index of the next task to be taken (taken atomically)
+  int task_depth; // the depth to search each task to
+
+  /* threads kept waiting between searches, which are started and stopped by set_threads_ai_2048 */
+  struct Worker workers[AI_MAX_THREADS]; // the calling thread, then the waiting threads
+  int num_threads; // threads used for each search (including the calling thread)
+  pthread_mutex_t lock; // held while handing out or finishing work
+  pthread_cond_t has_work; // signalled when the tasks are handed out, or the threads should stop
+  pthread_cond_t is_done; // signalled when the last busy thread finishes its tasks
+  unsigned round; // bumped each time tasks are handed out
+  int num_active; // number of waiting threads taking part in this round
+  int num_busy; // number of waiting threads yet to finish this round
+  int is_closing; // set when the waiting threads should stop
+};
+
+
+// Heuristic score of each row, which is added up over every row and column of a board
+static float ROW_HEURISTIC[ROW_COUNT];
+
+// Makes sure the heuristic table is only built once
+static pthread_once_t HEURISTIC_ONCE = PTHREAD_ONCE_INIT;
+
+
+/**
+ * Fill in the heuristic score of each row.
+ */
+static void build_heuristic(void) {
+  // each exponent raised to the power 3.5, so that big tiles weigh much more than small ones
+  static const float SUM_POWERS[BOARD_MAX_TILE + 1] = {
+    0.0f, 1.0f, 11.3f, 46.8f, 128.0f, 279.5f, 529.1f, 907.5f, 1448.2f, 2187.0f, 3162.3f, 4414.4f, 5986.0f, 7921.4f,
+    10267.1f, 13071.3f,
+  };
+
+  for (int row = 0; row < ROW_COUNT; row++) {
+    int line[SIZE];
+    for (int j = 0; j < SIZE; j++) {
+      line[j] = (row >> (4 * j)) & 0xF;
+    }
+
+    /* count the empty cells, and the matching pairs (runs of the same tile) */
+    float sum = 0.0f;
+    int empty = 0, merges = 0, run = 0, previous = 0;
+    for (int j = 0; j < SIZE; j++) {
+      sum += SUM_POWERS[line[j]];
+      if (line[j] == 0) {
+        empty++;
+        continue;
+      }
+
+      if (line[j] == previous) {
+        run++;
+      } else {
+        merges += run > 0 ? run + 1 : 0;
+        run = 0;
+      }
+      previous = line[j];
+    }
+    merges += run > 0 ? run + 1 : 0;
+
+    /* penalise the smaller of the rises and falls along the row (to the fourth power of each tile) */
+    float left = 0.0f, right = 0.0f;
+    for (int j = 1; j < SIZE; j++) {
+      const float before = (float) (line[j - 1] * line[j - 1] * line[j - 1] * line[j - 1]);
+      const float after = (float) (line[j] * line[j] * line[j] * line[j]);
+      if (line[j - 1] > line[j]) {
+        left += before - after;
+      } else {
+        right += after - before;
+      }
+    }
+
+    ROW_HEURISTIC[row] = LOST_PENALTY + EMPTY_WEIGHT * (float) empty + MERGES_WEIGHT * (float) merges -
+                         MONOTONICITY_WEIGHT * (left < right ? left : right) - SUM_WEIGHT * sum;
+  }
+}
+
+
+/**
+ * Get the time from a monotonic clock.
+ *
+ * @return the time in microseconds
+ */
+static long long now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+/**
+ * Score a position by how open and well-ordered it is.
+ *
+ * @param board the position
+ * @return the heuristic score of its rows and columns
+ */
+static float heuristic(const Board board) {
+  const Board columns = board_transpose(board);
+
+  float score = 0.0f;
+  for (int i = 0; i < SIZE; i++) {
+    score += ROW_HEURISTIC[(board >> (16 * i)) & 0xFFFF];
+    score += ROW_HEURISTIC[(columns >> (16 * i)) & 0xFFFF];
+  }
+
+  return score;
+}
+
+
+/**
+ * Find the slot in the table for a position.
+ *
+ * @param ai the search
+ * @param board the position
+ * @return the slot that the position is stored in, if it is stored at all
+ */
+static struct Entry *lookup(struct Ai *ai, const Board board) {
+  const uint64_t hash = board * 0x9E3779B97F4A7C15ull;
+  return ai->table + (hash >> (64 - AI_TABLE_BITS));
+}
+
+
+/**
+ * Check if a search has run out of time, checking the clock every so often.
+ *
+ * @param worker the thread's state, whose count of positions is incremented
+ * @return 1 if the search should stop, 0 otherwise
+ */
+static int is_out_of_time(struct Worker *worker) {
+  struct Ai *ai = worker->ai;
+
+  worker->nodes++;
+  if (ai->deadline && worker->nodes % CHECK_INTERVAL == 0 && now_us() > ai->deadline) {
+    __atomic_store_n(&ai->is_stopped, 1, __ATOMIC_RELAXED);
+    return 1;
+  }
+
+  return __atomic_load_n(&ai->is_stopped, __ATOMIC_RELAXED);
+}
+
+
+static float search_chance(struct Worker *worker, Board board, int depth, double prob);
+
+
+/**
+ * Get the expected score of the best move from a position.
+ *
+ * @param worker the thread's state
+ * @param board the position
+ * @param depth the number of moves left to look ahead (including this one)
+ * @param prob the chance of reaching this position
+ * @return the expected score of the best move (0 if no move is possible)
+ */
+static float search_max(struct Worker *worker, const Board board, const int depth, const double prob) {
+  float best = 0.0f;
+  for (int m = 0; m < 4; m++) {
+    Board moved;
+    int score;
+    if (board_move(board, (Move) m, &moved, &score) || moved == board) {
+      continue;
+    }
+
+    const float value = search_chance(worker, moved, depth, prob);
+    if (value > best) {
+      best = value;
+    }
+  }
+
+  return best;
+}
+
+
+/**
+ * Get the expected score of a position after a move, averaged over every tile that could be added.
+ *
+ * @param worker the thread's state
+ * @param board the position after the move
+ * @param depth the number of moves looked ahead up to and including the one that reached this position
+ * @param prob the chance of reaching this position
+ * @return the expected score
+ */
+static float search_chance(struct Worker *worker, const Board board, const int depth, const double prob) {
+  /* stop looking ahead at the last move, or once the position is too unlikely to matter */
+  if (depth <= 1 || prob < AI_PROB_CUTOFF) {
+    return heuristic(board);
+  }
+
+  if (is_out_of_time(worker)) {
+    return 0.0f;
+  }
+
+  /* use the value from another branch (or thread) that reached the same position */
+  struct Ai *ai = worker->ai;
+  struct Entry *entry = lookup(ai, board);
+  const uint64_t key = __atomic_load_n(&entry->key, __ATOMIC_RELAXED);
+  const uint64_t data = __atomic_load_n(&entry->data, __ATOMIC_RELAXED);
+  if ((key ^ data) == board && (uint16_t) (data >> 32) == ai->generation && (int) (data >> 48) >= depth) {
+    const uint32_t bits = (uint32_t) data;
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  /* a 2 is added nine times in ten, otherwise a 4 */
+  const int empty = board_count_empty(board);
+  const double cell_prob = prob / empty;
+  float total = 0.0f;
+  for (int i = 0; i < SIZE * SIZE; i++) {
+    if ((board >> (4 * i)) & 0xF) {
+      continue;
+    }
+
+    total += 0.9f * search_max(worker, board | (Board) 1 << (4 * i), depth - 1, cell_prob * 0.9);
+    total += 0.1f * search_max(worker, board | (Board) 2 << (4 * i), depth - 1, cell_prob * 0.1);
+  }
+  const float value = total / (float) empty;
+
+  /* values found after the deadline are missing branches */
+  if (!__atomic_load_n(&ai->is_stopped, __ATOMIC_RELAXED)) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint64_t new_data = bits | (uint64_t) ai->generation << 32 | (uint64_t) depth << 48;
+    __atomic_store_n(&entry->key, board ^ new_data, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->data, new_data, __ATOMIC_RELAXED);
+  }
+
+  return value;
+}
+
+
+/**
+ * Work through the tiles added after the root moves, until there are none left.
+ *
+ * @param worker the thread's state
+ */
+static void search_tasks(struct Worker *worker) {
+  struct Ai *ai = worker->ai;
+
+  while (!__atomic_load_n(&ai->is_stopped, __ATOMIC_RELAXED)) {
+    const int k = __atomic_fetch_add(&ai->next_task, 1, __ATOMIC_RELAXED);
+    if (k >= ai->num_tasks) {
+      break;
+    }
+
+    struct Task *task = &ai->tasks[k];
+    task->value = search_max(worker, task->board, ai->task_depth - 1, task->prob);
+  }
+}
+
+
+/**
+ * Wait for tiles to be handed out and search them, until the search is freed or the threads are changed.
+ *
+ * @param arg pointer to the worker's state
+ * @return NULL
+ */
+static void *search_worker(void *arg) {
+  struct Worker *worker = arg;
+  struct Ai *ai = worker->ai;
+
+  pthread_mutex_lock(&ai->lock);
+  while (1) {
+    while (ai->round == worker->round && !ai->is_closing) {
+      pthread_cond_wait(&ai->has_work, &ai->lock);
+    }
+    if (ai->is_closing) {
+      break;
+    }
+    worker->round = ai->round;
+
+    // only some of the threads are needed when there are few tiles
+    if (worker->index > ai->num_active) {
+      continue;
+    }
+
+    pthread_mutex_unlock(&ai->lock);
+    search_tasks(worker);
+    pthread_mutex_lock(&ai->lock);
+
+    if (--ai->num_busy == 0) {
+      pthread_cond_signal(&ai->is_done);
+    }
+  }
+  pthread_mutex_unlock(&ai->lock);
+
+  return NULL;
+}
+
+
+/**
+ * Search the tiles added after the root moves on several threads, with each thread taking a tile at a time.
+ *
+ * @param ai the search
+ * @param tasks the tiles to search, whose values are set
+ * @param num_tasks the number of tiles
+ * @param depth the depth of the search (counting the root move)
+ * @param max_threads the most threads to use (including this one)
+ */
+static void search_parallel(struct Ai *ai, struct Task *tasks, const int num_tasks, const int depth,
+                            const int max_threads) {
+  const int num_threads = max_threads < num_tasks ? max_threads : num_tasks;
+  for (int t = 0; t < num_threads; t++) {
+    ai->workers[t].nodes = 0;
+  }
+
+  /* wake the waiting threads (if any are needed), then work on the tiles in this thread too */
+  pthread_mutex_lock(&ai->lock);
+  ai->tasks = tasks;
+  ai->num_tasks = num_tasks;
+  ai->next_task = 0;
+  ai->task_depth = depth;
+  ai->num_active = num_threads - 1;
+  ai->num_busy = num_threads - 1;
+  if (ai->num_active > 0) {
+    ai->round++;
+    pthread_cond_broadcast(&ai->has_work);
+  }
+  pthread_mutex_unlock(&ai->lock);
+
+  search_tasks(&ai->workers[0]);
+
+  pthread_mutex_lock(&ai->lock);
+  while (ai->num_busy > 0) {
+    pthread_cond_wait(&ai->is_done, &ai->lock);
+  }
+  pthread_mutex_unlock(&ai->lock);
+
+  for (int t = 0; t < num_threads; t++) {
+    ai->nodes += ai->workers[t].nodes;
+  }
+}
+
+
+/**
+ * Stop the waiting threads of a search, leaving only the calling thread.
+ *
+ * @param ai the search
+ */
+static void stop_threads(struct Ai *ai) {
+  pthread_mutex_lock(&ai->lock);
+  ai->is_closing = 1;
+  pthread_cond_broadcast(&ai->has_work);
+  pthread_mutex_unlock(&ai->lock);
+
+  for (int t = 1; t < ai->num_threads; t++) {
+    pthread_join(ai->workers[t].thread, NULL);
+  }
+
+  ai->is_closing = 0;
+  ai->num_threads = 1;
+}
+
+
+/**
+ * Find a move in a grid that is too big for a board, by taking the first one that does anything.
+ *
+ * @param game the game state
+ * @param move set to the move
+ * @return 0 on success, 1 if there are no possible moves
+ */
+static int any_move(const struct Game *game, Move *move) {
+  for (int m = 0; m < 4; m++) {
+    struct Game copy = *game;
+    if (move_2048(&copy, (Move) m) == MOVE_SUCCESS) {
+      *move = (Move) m;
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+
+struct Ai *start_ai_2048(void) {
+  board_init();
+  pthread_once(&HEURISTIC_ONCE, build_heuristic);
+
+  struct Ai *ai = calloc(1, sizeof(struct Ai));
+  if (!ai) {
+    return NULL;
+  }
+
+  ai->table = calloc((size_t) 1 << AI_TABLE_BITS, sizeof(struct Entry));
+  if (!ai->table) {
+    free(ai);
+    return NULL;
+  }
+
+  pthread_mutex_init(&ai->lock, NULL);
+  pthread_cond_init(&ai->has_work, NULL);
+  pthread_cond_init(&ai->is_done, NULL);
+  for (int t = 0; t < AI_MAX_THREADS; t++) {
+    ai->workers[t].ai = ai;
+    ai->workers[t].index = t;
+  }
+  ai->num_threads = 1;
+
+  return ai;
+}
+
+
+void free_ai_2048(struct Ai *ai) {
+  if (ai) {
+    stop_threads(ai);
+    pthread_cond_destroy(&ai->is_done);
+    pthread_cond_destroy(&ai->has_work);
+    pthread_mutex_destroy(&ai->lock);
+    free(ai->table);
+    free(ai);
+  }
+}
+
+
+int set_threads_ai_2048(struct Ai *ai, const int num_threads) {
+  long n = num_threads;
+  if (n <= 0) {
+    n = sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  n = n < 1 ? 1 : n > AI_MAX_THREADS ? AI_MAX_THREADS : n;
+
+  /* start the threads afresh, keeping however many could be started */
+  stop_threads(ai);
+  while (ai->num_threads < n) {
+    ai->workers[ai->num_threads].round = ai->round; // so the thread waits for the next round, however late it starts
+    if (pthread_create(&ai->workers[ai->num_threads].thread, NULL, search_worker, &ai->workers[ai->num_threads])) {
+      break;
+    }
+    ai->num_threads++;
+  }
+
+  return ai->num_threads;
+}
+
+
+int best_move_2048(struct Ai *ai, const struct Game *game, const long budget_us, Move *move) {
+  const long long start = now_us();
+  ai->nodes = 0;
+  ai->depth = 0;
+  if (!board_fits(game->grid)) {
+    return any_move(game, move);
+  }
+
+  /* entries from earlier searches were made with a different deadline, so could be incomplete */
+  ai->generation++;
+  if (ai->generation == 0) {
+    memset(ai->table, 0, ((size_t) 1 << AI_TABLE_BITS) * sizeof(struct Entry));
+    ai->generation = 1;
+  }
+
+  /* find the moves that do anything */
+  const Board board = board_from_grid(game->grid);
+  Board moved[4];
+  int is_legal[4] = {0};
+  int has_move = 0;
+  for (int m = 0; m < 4; m++) {
+    int score;
+    is_legal[m] = !board_move(board, (Move) m, &moved[m], &score) && moved[m] != board;
+    has_move |= is_legal[m];
+  }
+  if (!has_move) {
+    return any_move(game, move); // nothing fits in a board (only possible when merging the biggest tiles)
+  }
+
+  /* share out every tile that could be added after each move, with the more likely 2s first so they start earliest */
+  struct Task tasks[MAX_TASKS];
+  Move task_moves[MAX_TASKS];
+  int num_tasks = 0;
+  for (int tile = 1; tile <= 2; tile++) {
+    for (int m = 0; m < 4; m++) {
+      if (!is_legal[m]) {
+        continue;
+      }
+
+      const double tile_prob = (tile == 1 ? 0.9 : 0.1) / board_count_empty(moved[m]);
+      for (int i = 0; i < SIZE * SIZE; i++) {
+        if (!((moved[m] >> (4 * i)) & 0xF)) {
+          tasks[num_tasks].board = moved[m] | (Board) tile << (4 * i);
+          tasks[num_tasks].prob = tile_prob;
+          task_moves[num_tasks++] = (Move) m;
+        }
+      }
+    }
+  }
+
+  for (int depth = 1; depth <= AI_MAX_DEPTH; depth++) {
+    /* the first search always finishes, so there is always a move */
+    ai->deadline = depth == 1 ? 0 : start + budget_us;
+    ai->is_stopped = 0;
+
+    float values[4] = {0};
+    if (depth == 1) {
+      for (int m = 0; m < 4; m++) {
+        values[m] = is_legal[m] ? heuristic(moved[m]) : 0.0f;
+      }
+    } else {
+      // shallow searches are quicker than waking the threads
+      search_parallel(ai, tasks, num_tasks, depth, depth < PARALLEL_DEPTH ? 1 : ai->num_threads);
+      for (int k = 0; k < num_tasks; k++) {
+        values[task_moves[k]] += (float) tasks[k].prob * tasks[k].value;
+      }
+    }
+
+    if (ai->is_stopped) {
+      break;
+    }
+
+    int found = 0;
+    for (int m = 0; m < 4; m++) {
+      if (is_legal[m] && (!found || values[m] > values[*move])) {
+        found = 1;
+        *move = (Move) m;
+      }
+    }
+    ai->depth = depth;
+
+    if (now_us() > start + budget_us) {
+      break;
+    }
+  }
+
+  return 0;
+}
+
+
+void stats_ai_2048(const struct Ai *ai, int *depth, long *nodes) {
+  *depth = ai->depth;
+  *nodes = ai->nodes;
+}
@@ -0,0 +1,76 @@
+#ifndef AI_2048_H
+#define AI_2048_H
+
+#include "src/core/game_2048.h"
+
+
+#define AI_MAX_DEPTH (10) // most moves looked ahead
+#define AI_PROB_CUTOFF (0.0001) // positions less likely than this are not searched any further
+#define AI_TABLE_BITS (20) // log2 of the number of positions remembered between branches of the search
+#define AI_MAX_THREADS (64) // the most threads used by a single search
+
+
+/**
+ * Expectimax search for the best move, with its own table of positions (see start_ai_2048).
+ */
+struct Ai;
+
+
+/**
+ * Set up a search for the best move in a game of 2048.
+ *
+ * The search looks ahead over every move and every tile that could be added (a 2 nine times in ten, otherwise a 4),
+ * scoring the positions it ends on by how open and well-ordered the grid is. It searches one move deeper at a time
+ * until it runs out of time, only keeping the result of the deepest search that finished.
+ *
+ * @return The search, or NULL if it could not be allocated (free with free_ai_2048).
+ */
+struct Ai *start_ai_2048(void);
+
+
+/**
+ * Free a search for the best move.
+ *
+ * @param ai The search.
+ */
+void free_ai_2048(struct Ai *ai);
+
+
+/**
+ * Set the number of threads used by each search for the best move.
+ *
+ * Every tile that could be added after each first move is shared out between the threads, which remember positions in
+ * the same table. The threads are started here and wait between searches (until the number of threads is changed
+ * again or the search is freed). Searches shallower than three moves always run on the calling thread, since waking
+ * the threads would take longer. By default only the calling thread is used.
+ *
+ * @param ai The search.
+ * @param num_threads The number of threads (0 for one per CPU core), clamped between 1 and AI_MAX_THREADS.
+ * @return The number of threads that will be used (fewer than asked for if some could not be started).
+ */
+int set_threads_ai_2048(struct Ai *ai, int num_threads);
+
+
+/**
+ * Find the best move in a game.
+ *
+ * @param ai The search.
+ * @param game The game state (which is not changed).
+ * @param budget_us How long the search may take, in microseconds. At least a one move search is always finished.
+ * @param move Set to the best move.
+ * @return 0 on success, 1 if there are no possible moves.
+ */
+int best_move_2048(struct Ai *ai, const struct Game *game, long budget_us, Move *move);
+
+
+/**
+ * Get details of the last search for the best move.
+ *
+ * @param ai The search.
+ * @param depth Set to the number of moves looked ahead by the deepest search that finished.
+ * @param nodes Set to the number of positions visited.
+ */
+void stats_ai_2048(const struct Ai *ai, int *depth, long *nodes);
+
+
+#endif //AI_2048_H
@@ -0,0 +1,159 @@
+#include "anagram.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#define ANAGRAM_HASH (0x9E3779B97F4A7C15u) // multiplier spreading signatures over the hash table
+
+
+/**
+ * A word waiting to be grouped by signature.
+ */
+struct Entry {
+  uint64_t signature; // signature of the word
+  uint32_t index; // position of the word in alphabetical order
+};
+
+
+/**
+ * Compare two words by signature, then alphabetically.
+ *
+ * @param a pointer to the first entry
+ * @param b pointer to the second entry
+ * @return the order of the entries, as for strcmp
+ */
+static int compare_entries(const void *a, const void *b) {
+  const struct Entry *x = a;
+  const struct Entry *y = b;
+  if (x->signature != y->signature) {
+    return x->signature < y->signature ? -1 : 1;
+  }
+
+  return x->index < y->index ? -1 : x->index > y->index;
+}
+
+
+/**
+ * Get the first slot to try for a signature.
+ *
+ * @param anagram pointer to the index
+ * @param signature the signature
+ * @return the slot in the hash table
+ */
+static uint32_t home_bucket(const Anagram *anagram, const uint64_t signature) {
+  return (uint32_t) ((signature * ANAGRAM_HASH) >> 32) & (anagram->num_buckets - 1);
+}
+
+
+uint64_t anagram_signature(const int counts[26]) {
+  uint64_t signature = 0;
+  int len = 0;
+  for (int k = 0; k < 26; k++) {
+    for (int c = 0; c < counts[k]; c++) {
+      signature = signature << 5 | (uint64_t) (k + 1);
+    }
+    len += counts[k];
+  }
+
+  return len <= ANAGRAM_MAX_LEN ? signature : 0;
+}
+
+
+int anagram_from_dict(Anagram *anagram, const Dict *dict, const int max_len) {
+  memset(anagram, 0, sizeof(Anagram));
+  if (max_len < 1 || max_len > ANAGRAM_MAX_LEN) {
+    return 1;
+  }
+
+  char *sorted;
+  uint32_t n;
+  if (dict_list_words(dict, max_len, &sorted, &n)) {
+    return 1;
+  }
+
+  /* work out the signature of each word */
+  const size_t width = (size_t) max_len + 1;
+  struct Entry *entries = malloc((n ? n : 1) * sizeof(struct Entry));
+  anagram->words = malloc((n ? n : 1) * width);
+  uint32_t num_buckets = 16;
+  while (num_buckets < 2 * n) {
+    num_buckets *= 2;
+  }
+  anagram->buckets = calloc(num_buckets, sizeof(AnagramBucket));
+  if (!entries || !anagram->words || !anagram->buckets) {
+    free(entries);
+    free(sorted);
+    anagram_free(anagram);
+    return 1;
+  }
+
+  for (uint32_t i = 0; i < n; i++) {
+    int counts[26] = {0};
+    for (const char *ch = sorted + i * width; *ch; ch++) {
+      counts[*ch - 'a']++;
+    }
+    entries[i].signature = anagram_signature(counts);
+    entries[i].index = i;
+  }
+
+  /* group the words by signature, adding each group to the hash table */
+  qsort(entries, n, sizeof(struct Entry), compare_entries);
+  anagram->num_words = n;
+  anagram->max_len = max_len;
+  anagram->num_buckets = num_buckets;
+
+  for (uint32_t i = 0; i < n; i++) {
+    memcpy(anagram->words + i * width, sorted + entries[i].index * width, width);
+
+    if (i > 0 && entries[i].signature == entries[i - 1].signature) {
+      continue;
+    }
+
+    uint32_t slot = home_bucket(anagram, entries[i].signature);
+    while (anagram->buckets[slot].signature) {
+      slot = (slot + 1) & (num_buckets - 1);
+    }
+    anagram->buckets[slot].signature = entries[i].signature;
+    anagram->buckets[slot].first = i;
+
+    uint32_t count = 1;
+    while (i + count < n && entries[i + count].signature == entries[i].signature) {
+      count++;
+    }
+    anagram->buckets[slot].count = count;
+  }
+
+  free(entries);
+  free(sorted);
+
+  return 0;
+}
+
+
+void anagram_free(Anagram *anagram) {
+  free(anagram->words);
+  free(anagram->buckets);
+
+  memset(anagram, 0, sizeof(Anagram));
+}
+
+
+const char *anagram_find(const Anagram *anagram, const uint64_t signature, uint32_t *count) {
+  *count = 0;
+  if (!signature || !anagram->num_buckets) {
+    return NULL;
+  }
+
+  /* the table is never full, so there is always an empty slot to stop at */
+  for (uint32_t slot = home_bucket(anagram, signature);; slot = (slot + 1) & (anagram->num_buckets - 1)) {
+    const AnagramBucket *bucket = &anagram->buckets[slot];
+    if (bucket->signature == signature) {
+      *count = bucket->count;
+      return anagram->words + (size_t) bucket->first * ((size_t) anagram->max_len + 1);
+    }
+    if (!bucket->signature) {
+      return NULL;
+    }
+  }
+}
@@ -0,0 +1,77 @@
+#ifndef ANAGRAM_H
+#define ANAGRAM_H
+
+#include <stdint.h>
+
+#include "src/core/dict.h"
+
+
+#define ANAGRAM_MAX_LEN (12) // longest word that can be indexed (5 bits per letter in a 64-bit signature)
+
+
+/**
+ * A slot in the hash table of an anagram index.
+ */
+typedef struct AnagramBucket {
+  uint64_t signature; // signature shared by the words (0 for an empty slot)
+  uint32_t first; // index of the first word with this signature
+  uint32_t count; // number of words with this signature
+} AnagramBucket;
+
+
+/**
+ * A read-only index of the words in a dictionary by their letters, regardless of order.
+ *
+ * Each word's signature packs its letters in sorted order, so anagrams share a signature. The words are grouped by
+ * signature, and an open addressing hash table finds the group for a signature with a single probe in most cases.
+ */
+typedef struct Anagram {
+  char *words; // the words (each taking max_len + 1 chars), grouped by signature and alphabetical within each group
+  uint32_t num_words; // number of words
+  int max_len; // longest word in the index
+
+  AnagramBucket *buckets; // hash table of the groups of words
+  uint32_t num_buckets; // size of the hash table (a power of 2)
+} Anagram;
+
+
+/**
+ * Get the signature of a set of letters.
+ *
+ * @param counts the number of each letter
+ * @return the signature (0 for no letters, or more than ANAGRAM_MAX_LEN letters)
+ */
+uint64_t anagram_signature(const int counts[26]);
+
+
+/**
+ * Index the words in a dictionary up to a given length.
+ *
+ * @param anagram pointer to the index to set up (free with anagram_free)
+ * @param dict pointer to the dictionary
+ * @param max_len the longest words to index (at most ANAGRAM_MAX_LEN)
+ * @return 0 on success, 1 on failure (due to failed malloc or too long a length)
+ */
+int anagram_from_dict(Anagram *anagram, const Dict *dict, int max_len);
+
+
+/**
+ * Free the memory used by an anagram index.
+ *
+ * @param anagram pointer to the index
+ */
+void anagram_free(Anagram *anagram);
+
+
+/**
+ * Find the words with a given signature.
+ *
+ * @param anagram pointer to the index
+ * @param signature the signature to look up (see anagram_signature)
+ * @param count set to the number of words found
+ * @return the first of the words (each taking max_len + 1 chars), or NULL if there are none
+ */
+const char *anagram_find(const Anagram *anagram, uint64_t signature, uint32_t *count);
+
+
+#endif //ANAGRAM_H
@@ -0,0 +1,142 @@
+#include "board_2048.h"
+
+#include <assert.h>
+#include <pthread.h>
+
+
+static_assert(SIZE == 4, "boards only hold a 4x4 grid");
+
+
+#define ROW_MASK (0xFFFFu) // bits of a single row of a board
+#define ROW_OVERFLOW (-1) // score of a row that cannot be moved without overflowing a cell
+
+
+// Each row after moving it left and right, indexed by the row before the move
+static uint16_t ROW_LEFT[ROW_MASK + 1];
+static uint16_t ROW_RIGHT[ROW_MASK + 1];
+
+// Score of moving each row left (or ROW_OVERFLOW), which is the score of moving the reversed row right
+static int ROW_SCORE[ROW_MASK + 1];
+
+// Makes sure the tables are only built once
+static pthread_once_t TABLES_ONCE = PTHREAD_ONCE_INIT;
+
+
+/**
+ * Reverse the order of the cells in a row.
+ *
+ * @param row the row
+ * @return the row with its leftmost cell rightmost
+ */
+static uint16_t reverse_row(const uint16_t row) {
+  return (uint16_t) ((row >> 12) | ((row >> 4) & 0x00F0u) | ((row << 4) & 0x0F00u) | (row << 12));
+}
+
+
+/**
+ * Fill in the row tables.
+ */
+static void build_tables(void) {
+  for (uint32_t row = 0; row <= ROW_MASK; row++) {
+    int line[SIZE];
+    for (int j = 0; j < SIZE; j++) {
+      line[j] = (int) (row >> (4 * j)) & 0xF;
+    }
+
+    int score = 0;
+    slide_line_2048(line, 1, &score); // the same rules as moving a grid
+
+    uint16_t left = 0;
+    int overflow = 0;
+    for (int j = 0; j < SIZE; j++) {
+      overflow |= line[j] > BOARD_MAX_TILE;
+      left |= (uint16_t) ((line[j] & 0xF) << (4 * j));
+    }
+
+    ROW_LEFT[row] = left;
+    ROW_SCORE[row] = overflow ? ROW_OVERFLOW : score;
+    ROW_RIGHT[reverse_row((uint16_t) row)] = reverse_row(left);
+  }
+}
+
+
+void board_init(void) {
+  pthread_once(&TABLES_ONCE, build_tables);
+}
+
+
+int board_fits(const int grid[SIZE * SIZE]) {
+  for (int i = 0; i < SIZE * SIZE; i++) {
+    if (grid[i] < 0 || grid[i] > BOARD_MAX_TILE) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+
+Board board_from_grid(const int grid[SIZE * SIZE]) {
+  Board board = 0;
+  for (int i = 0; i < SIZE * SIZE; i++) {
+    board |= (Board) (grid[i] & 0xF) << (4 * i);
+  }
+
+  return board;
+}
+
+
+void board_to_grid(const Board board, int grid[SIZE * SIZE]) {
+  for (int i = 0; i < SIZE * SIZE; i++) {
+    grid[i] = (int) (board >> (4 * i)) & 0xF;
+  }
+}
+
+
+Board board_transpose(const Board board) {
+  /* swap the off-diagonal cells within each 2x2 block, then the off-diagonal 2x2 blocks */
+  const Board a = (board & 0xF0F00F0FF0F00F0Full) |
+                  ((board & 0x0000F0F00000F0F0ull) << 12) |
+                  ((board & 0x0F0F00000F0F0000ull) >> 12);
+
+  return (a & 0xFF00FF0000FF00FFull) |
+         ((a & 0x00FF00FF00000000ull) >> 24) |
+         ((a & 0x00000000FF00FF00ull) << 24);
+}
+
+
+int board_count_empty(const Board board) {
+  /* squash each cell down to a single bit that is set if the cell is in use */
+  Board used = board | (board >> 1);
+  used |= used >> 2;
+  used &= 0x1111111111111111ull;
+
+  return SIZE * SIZE - __builtin_popcountll(used);
+}
+
+
+int board_move(const Board board, const Move move, Board *result, int *score) {
+  board_init();
+
+  /* columns are moved as the rows of the transposed board */
+  const int is_column = move == UP || move == DOWN;
+  const uint16_t *table = move == LEFT || move == UP ? ROW_LEFT : ROW_RIGHT;
+  const Board rows = is_column ? board_transpose(board) : board;
+
+  Board moved = 0;
+  int total = 0;
+  for (int i = 0; i < SIZE; i++) {
+    const uint16_t row = (uint16_t) (rows >> (16 * i));
+    const int row_score = ROW_SCORE[table == ROW_LEFT ? row : reverse_row(row)];
+    if (row_score == ROW_OVERFLOW) {
+      return 1;
+    }
+
+    moved |= (Board) table[row] << (16 * i);
+    total += row_score;
+  }
+
+  *result = is_column ? board_transpose(moved) : moved;
+  *score = total;
+  return 0;
+}
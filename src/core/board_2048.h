@@ -0,0 +1,90 @@
+#ifndef BOARD_2048_H
+#define BOARD_2048_H
+
+#include <stdint.h>
+
+#include "src/core/game_2048.h"
+
+
+#define BOARD_MAX_TILE (15) // largest exponent that fits in a cell of a board (32768)
+
+
+/**
+ * A 2048 grid packed into a single 64-bit integer.
+ *
+ * Each cell holds the exponent of its tile in 4 bits (0 for an empty cell), in the same order as struct Game's grid:
+ * cell i takes bits 4i to 4i + 3, so each row of the grid is one 16-bit chunk with its leftmost cell lowest. Moving a
+ * whole row is then a single table lookup, and columns are moved by transposing the board and moving its rows.
+ */
+typedef uint64_t Board;
+
+
+/**
+ * Build the row tables used to move boards.
+ *
+ * This is done automatically on first use, but can be called up front to avoid a delay in the first move. It is safe
+ * to call from several threads at once.
+ */
+void board_init(void);
+
+
+/**
+ * Check if every tile in a grid fits in a board.
+ *
+ * @param grid the grid, with tiles represented by powers of 2
+ * @return 1 if every exponent is at most BOARD_MAX_TILE, 0 otherwise
+ */
+int board_fits(const int grid[SIZE * SIZE]);
+
+
+/**
+ * Pack a grid into a board.
+ *
+ * @param grid the grid, whose tiles must fit in a board (see board_fits)
+ * @return the board
+ */
+Board board_from_grid(const int grid[SIZE * SIZE]);
+
+
+/**
+ * Unpack a board into a grid.
+ *
+ * @param board the board
+ * @param grid set to the tiles of the board
+ */
+void board_to_grid(Board board, int grid[SIZE * SIZE]);
+
+
+/**
+ * Swap the rows and columns of a board.
+ *
+ * @param board the board
+ * @return the board reflected in its leading diagonal
+ */
+Board board_transpose(Board board);
+
+
+/**
+ * Count the empty cells of a board.
+ *
+ * @param board the board
+ * @return the number of empty cells
+ */
+int board_count_empty(Board board);
+
+
+/**
+ * Move the tiles of a board in a direction, merging any matching pairs.
+ *
+ * This follows the same rules as move_2048, but does not add a new tile.
+ *
+ * @param board the board
+ * @param move the direction to move the tiles
+ * @param result set to the board after the move (the same as the board if nothing could move)
+ * @param score set to the score gained from the merges
+ * @return 0 on success, 1 if a merge would make a tile bigger than BOARD_MAX_TILE (in which case nothing is set)
+ */
+int board_move(Board board, Move move, Board *result, int *score);
+
+
+#endif //BOARD_2048_H
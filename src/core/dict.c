@@ -0,0 +1,492 @@
+#include "dict.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+static_assert(sizeof(DictNode) == 16, "dictionary nodes must not contain any padding");
+static_assert(sizeof(DictHeader) % 4 == 0, "dictionary nodes must be aligned in a file");
+
+
+#define NODE_MAP_SIZE (1024) // initial capacity of a node map (must be a power of 2)
+
+
+/**
+ * Map from distinct trie nodes to the index of their first child in a flattened dictionary.
+ *
+ * Nodes can be shared between several parents (see trie_init_dawg), so this makes sure that the children of each node
+ * are only stored once.
+ */
+struct NodeMap {
+  const Trie **keys; // open-addressed table of nodes (NULL for an empty slot)
+  uint32_t *first; // index of the first child of each node
+  size_t capacity; // size of the table (always a power of 2)
+  size_t count; // number of nodes in the table
+};
+
+
+/**
+ * Find the slot in a node map for a node.
+ *
+ * @param map pointer to the map
+ * @param node pointer to the node to find
+ * @return the index of the slot holding the node, or of the empty slot where it belongs
+ */
+static size_t map_find(const struct NodeMap *map, const Trie *node) {
+  uint64_t hash = (uintptr_t) node;
+  hash ^= hash >> 29;
+  hash *= 0xD6E8FEB86659FD93u;
+  hash ^= hash >> 32;
+
+  size_t i = (size_t) hash & (map->capacity - 1);
+  while (map->keys[i] && map->keys[i] != node) {
+    i = (i + 1) & (map->capacity - 1);
+  }
+
+  return i;
+}
+
+
+/**
+ * Add a node to a node map, growing the map if needed.
+ *
+ * @param map pointer to the map
+ * @param node pointer to the node to add (must not already be in the map)
+ * @param first index of the first child of the node
+ * @return 0 on success, 1 on failure (due to failed malloc)
+ */
+static int map_add(struct NodeMap *map, const Trie *node, const uint32_t first) {
+  if (2 * (map->count + 1) > map->capacity) {
+    const struct NodeMap old = *map;
+
+    map->capacity = 2 * old.capacity;
+    map->keys = calloc(map->capacity, sizeof(Trie *));
+    map->first = malloc(map->capacity * sizeof(uint32_t));
+    if (!map->keys || !map->first) {
+      free(map->keys);
+      free(map->first);
+      *map = old;
+      return 1;
+    }
+
+    for (size_t i = 0; i < old.capacity; i++) {
+      if (old.keys[i]) {
+        const size_t j = map_find(map, old.keys[i]);
+        map->keys[j] = old.keys[i];
+        map->first[j] = old.first[i];
+      }
+    }
+    free(old.keys);
+    free(old.first);
+  }
+
+  const size_t i = map_find(map, node);
+  map->keys[i] = node;
+  map->first[i] = first;
+  map->count++;
+
+  return 0;
+}
+
+
+/**
+ * Count the children of a flattened node.
+ *
+ * @param node pointer to the node
+ * @return the number of children
+ */
+static uint32_t count_children(const DictNode *node) {
+  return (uint32_t) __builtin_popcount(node->mask & DICT_LETTERS);
+}
+
+
+/**
+ * Set up a flattened node from a trie node.
+ *
+ * @param out pointer to the flattened node
+ * @param node pointer to the trie node
+ * @param first index of the first child of the node
+ */
+static void flatten_node(DictNode *out, const Trie *node, const uint32_t first) {
+  memset(out, 0, sizeof(DictNode)); // the summary is filled in by summarise_node once every node is in place
+  out->mask = node->is_terminal ? DICT_TERMINAL : 0;
+  out->first = first;
+
+  for (int i = 0; i < 26; i++) {
+    if (node->children[i]) {
+      out->mask |= 1u << i;
+    }
+  }
+}
+
+
+/**
+ * Fill in the letters, lengths and scores that can be reached from a flattened node, along with all of the nodes below it.
+ *
+ * Nodes that share a block of children are only summarised once, since the summary only depends on the words below.
+ *
+ * @param nodes the array of flattened nodes
+ * @param index the index of the node to summarise
+ * @param scores the score of each letter
+ * @param done flag for each node that has already been summarised
+ */
+static void summarise_node(DictNode *nodes, const uint32_t index, const char scores[26], unsigned char *done) {
+  if (done[index]) {
+    return;
+  }
+  done[index] = 1;
+
+  DictNode *node = nodes + index;
+  uint32_t letters = node->mask & DICT_LETTERS;
+  for (uint32_t c = node->first; letters; c++) {
+    summarise_node(nodes, c, scores, done);
+
+    /* a child contributes its own letter, then everything below it */
+    const DictNode *child = nodes + c;
+    const uint32_t bit = letters & (~letters + 1);
+    letters ^= bit;
+    node->reachable |= bit | child->reachable;
+
+    const int remaining = 1 + ((child->mask & DICT_TERMINAL) ? 0 : child->min_remaining);
+    if (node->min_remaining == 0 || remaining < node->min_remaining) {
+      node->min_remaining = (uint8_t) (remaining > UINT8_MAX ? UINT8_MAX : remaining);
+    }
+
+    const int score = scores[__builtin_ctz(bit)] + child->max_score;
+    if (score > node->max_score) {
+      node->max_score = (uint8_t) (score > DICT_MAX_SCORE ? DICT_MAX_SCORE : score);
+    }
+  }
+}
+
+
+int dict_from_trie(Dict *dict, const Trie *root, const char scores[26]) {
+  /* a breadth first traversal of the distinct nodes places all of the children of a node next to each other */
+  // the root has no parent, so it sits on its own at the start of the array
+  struct NodeMap map = {
+    .keys = calloc(NODE_MAP_SIZE, sizeof(Trie *)),
+    .first = malloc(NODE_MAP_SIZE * sizeof(uint32_t)),
+    .capacity = NODE_MAP_SIZE,
+    .count = 0,
+  };
+  size_t queue_capacity = NODE_MAP_SIZE;
+  const Trie **queue = malloc(queue_capacity * sizeof(Trie *));
+
+  int err = !map.keys || !map.first || !queue || map_add(&map, root, 1);
+  uint32_t num_nodes = 1;
+  size_t tail = 0;
+  if (!err) {
+    queue[tail++] = root;
+  }
+
+  for (size_t head = 0; head < tail && !err; head++) {
+    const Trie *node = queue[head];
+    DictNode flat;
+    flatten_node(&flat, node, num_nodes);
+    map.first[map_find(&map, node)] = num_nodes;
+    num_nodes += count_children(&flat);
+
+    for (int i = 0; i < 26 && !err; i++) {
+      const Trie *child = node->children[i];
+
+      /* only visit each distinct node once */
+      if (!child || map.keys[map_find(&map, child)]) {
+        continue;
+      }
+
+      if (tail == queue_capacity) {
+        queue_capacity *= 2;
+        const Trie **bigger = realloc(queue, queue_capacity * sizeof(Trie *));
+        if (!bigger) {
+          err = 1;
+          break;
+        }
+        queue = bigger;
+      }
+
+      queue[tail++] = child;
+      err = map_add(&map, child, 0);
+    }
+  }
+
+  DictNode *nodes = err ? NULL : malloc(num_nodes * sizeof(DictNode));
+  if (nodes) {
+    /* every edge becomes a node in its parent's block, pointing at the (shared) block of its own children */
+    flatten_node(nodes, root, map.first[map_find(&map, root)]);
+    for (size_t q = 0; q < tail; q++) {
+      const Trie *node = queue[q];
+      DictNode *out = nodes + map.first[map_find(&map, node)];
+
+      for (int i = 0; i < 26; i++) {
+        const Trie *child = node->children[i];
+        if (child) {
+          flatten_node(out++, child, map.first[map_find(&map, child)]);
+        }
+      }
+    }
+  }
+
+  free(map.keys);
+  free(map.first);
+  free(queue);
+
+  /* work out what can be reached from each node, now that the children can be found */
+  unsigned char *done = nodes ? calloc(num_nodes, 1) : NULL;
+  if (!done) {
+    free(nodes);
+    return 1;
+  }
+  summarise_node(nodes, 0, scores, done);
+  free(done);
+
+  dict->nodes = nodes;
+  dict->num_nodes = num_nodes;
+  dict->storage = nodes;
+  dict->map = NULL;
+  dict->map_size = 0;
+
+  return 0;
+}
+
+
+/**
+ * Compute the FNV-1a hash of an array of nodes.
+ *
+ * @param nodes the nodes to hash
+ * @param num_nodes the number of nodes
+ * @return the hash
+ */
+static uint32_t checksum(const DictNode *nodes, const uint32_t num_nodes) {
+  const unsigned char *bytes = (const unsigned char *) nodes;
+  const size_t n = num_nodes * sizeof(DictNode);
+
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < n; i++) {
+    hash ^= bytes[i];
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+
+int dict_open(Dict *dict, const char *path) {
+  /* map the whole file */
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return 1;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) || st.st_size < (off_t) sizeof(DictHeader)) {
+    close(fd);
+    return 1;
+  }
+
+  const size_t size = (size_t) st.st_size;
+  void *map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd); // the mapping stays valid after the file is closed
+  if (map == MAP_FAILED) {
+    return 1;
+  }
+
+  /* check that the header matches this build */
+  const DictHeader *header = map;
+  if (
+    memcmp(header->magic, DICT_MAGIC, sizeof(header->magic)) ||
+    header->byte_order != DICT_BYTE_ORDER ||
+    header->version != DICT_VERSION
+  ) {
+    munmap(map, size);
+    return 2;
+  }
+
+  /* check that the nodes are intact, and cannot point outside of the file */
+  const DictNode *nodes = (const DictNode *) (header + 1);
+  const uint32_t num_nodes = header->num_nodes;
+  int is_corrupt = num_nodes == 0 || size != sizeof(DictHeader) + num_nodes * sizeof(DictNode);
+  for (uint32_t i = 0; i < num_nodes && !is_corrupt; i++) {
+    is_corrupt = (nodes[i].mask & ~(DICT_LETTERS | DICT_TERMINAL)) ||
+                 (nodes[i].reachable & ~DICT_LETTERS) ||
+                 (uint64_t) nodes[i].first + count_children(nodes + i) > num_nodes;
+  }
+  if (is_corrupt || checksum(nodes, num_nodes) != header->checksum) {
+    munmap(map, size);
+    return 3;
+  }
+
+  dict->nodes = nodes;
+  dict->num_nodes = num_nodes;
+  dict->storage = NULL;
+  dict->map = map;
+  dict->map_size = size;
+
+  return 0;
+}
+
+
+int dict_write(const Dict *dict, const char *path) {
+  DictHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, DICT_MAGIC, sizeof(DICT_MAGIC));
+  header.byte_order = DICT_BYTE_ORDER;
+  header.version = DICT_VERSION;
+  header.num_nodes = dict->num_nodes;
+  header.checksum = dict_checksum(dict);
+
+  FILE *fp = fopen(path, "wb");
+  if (!fp) {
+    return 1;
+  }
+
+  int err = fwrite(&header, sizeof(header), 1, fp) != 1;
+  err |= fwrite(dict->nodes, sizeof(DictNode), dict->num_nodes, fp) != dict->num_nodes;
+  err |= fclose(fp) != 0;
+  if (err) {
+    remove(path);
+    return 1;
+  }
+
+  return 0;
+}
+
+
+uint32_t dict_checksum(const Dict *dict) {
+  return checksum(dict->nodes, dict->num_nodes);
+}
+
+
+void dict_free(Dict *dict) {
+  if (dict->map) {
+    munmap(dict->map, dict->map_size);
+  }
+  free(dict->storage);
+
+  dict->storage = NULL;
+  dict->map = NULL;
+  dict->map_size = 0;
+  dict->nodes = NULL;
+  dict->num_nodes = 0;
+}
+
+
+uint32_t dict_step(const Dict *dict, const uint32_t node, const char ch) {
+  if (ch < 'a' || ch > 'z') {
+    return DICT_NONE;
+  }
+
+  const DictNode *parent = dict->nodes + node;
+  const uint32_t bit = 1u << TRIE_IDX(ch);
+  if (!(parent->mask & bit)) {
+    return DICT_NONE;
+  }
+
+  return parent->first + (uint32_t) __builtin_popcount(parent->mask & (bit - 1));
+}
+
+
+int dict_is_word(const Dict *dict, const uint32_t node) {
+  return (dict->nodes[node].mask & DICT_TERMINAL) != 0;
+}
+
+
+int dict_has_children(const Dict *dict, const uint32_t node) {
+  return (dict->nodes[node].mask & DICT_LETTERS) != 0;
+}
+
+
+uint32_t dict_reachable_letters(const Dict *dict, const uint32_t node) {
+  return dict->nodes[node].reachable;
+}
+
+
+int dict_min_remaining(const Dict *dict, const uint32_t node) {
+  return dict->nodes[node].min_remaining;
+}
+
+
+int dict_max_score(const Dict *dict, const uint32_t node) {
+  return dict->nodes[node].max_score;
+}
+
+
+/**
+ * List the words below a node, in alphabetical order.
+ *
+ * @param dict pointer to the dictionary
+ * @param node the index of the node
+ * @param word the letters leading to the node, with space for the longest word
+ * @param len the number of letters leading to the node
+ * @param max_len the length of the longest words to list
+ * @param words array to copy each word into (NULL to only count the words)
+ * @param num_words the number of words listed so far, which is updated
+ */
+static void list_words(
+  const Dict *dict, const uint32_t node, char *word, const int len, const int max_len, char *words, uint32_t *num_words
+) {
+  if (dict_is_word(dict, node)) {
+    if (words) {
+      memcpy(words + (size_t) *num_words * (size_t) (max_len + 1), word, (size_t) max_len + 1);
+    }
+    (*num_words)++;
+  }
+
+  if (len == max_len) {
+    return;
+  }
+
+  uint32_t child = dict->nodes[node].first;
+  for (int i = 0; i < 26; i++) {
+    if (dict->nodes[node].mask & (1u << i)) {
+      word[len] = (char) ('a' + i);
+      list_words(dict, child++, word, len + 1, max_len, words, num_words);
+      word[len] = '\0';
+    }
+  }
+}
+
+
+int dict_list_words(const Dict *dict, const int max_len, char **words, uint32_t *num_words) {
+  char *word = calloc((size_t) max_len + 1, 1);
+  if (!word) {
+    return 1;
+  }
+
+  /* count the words first, so the list can be allocated in one go */
+  uint32_t count = 0;
+  list_words(dict, 0, word, 0, max_len, NULL, &count);
+
+  *words = calloc(count ? count : 1, (size_t) max_len + 1);
+  if (!*words) {
+    free(word);
+    return 1;
+  }
+
+  *num_words = 0;
+  list_words(dict, 0, word, 0, max_len, *words, num_words);
+  free(word);
+
+  return 0;
+}
+
+
+int dict_contains(const Dict *dict, const char *word, int prefix) {
+  uint32_t node = 0;
+
+  for (int i = 0; word[i] != '\0'; i++) {
+    /* only keep going if the correct child node exists */
+    node = dict_step(dict, node, word[i]);
+    if (node == DICT_NONE) {
+      return 0;
+    }
+  }
+
+  /* the word is in the dictionary, but is it a full word? */
+  return prefix || dict_is_word(dict, node);
+}
@@ -0,0 +1,207 @@
+#ifndef DICT_H
+#define DICT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "src/core/trie.h"
+
+
+#define DICT_MAGIC ("PZLDICT") // identifies a dictionary file (including the null-terminator)
+#define DICT_VERSION (4) // bumped whenever the layout of a dictionary file changes
+#define DICT_BYTE_ORDER (0x01020304u) // written in native byte order to detect foreign files
+#define DICT_NONE (UINT32_MAX) // node index returned when there is no such node
+#define DICT_MAX_SCORE (UINT8_MAX) // largest score bound stored in a node (larger bounds are clamped to this)
+
+
+#define DICT_TERMINAL (1u << 26) // bit set in a node mask if the node is the end of a word
+#define DICT_LETTERS (DICT_TERMINAL - 1) // bits set in a node mask for each child letter
+
+
+/**
+ * A single node of a flattened trie.
+ *
+ * All of the nodes live in one array, with the root at index 0. The children of a node are stored contiguously (in
+ * alphabetical order) starting from index `first`, so links are array indices rather than pointers. Rather than
+ * storing its own letter, each node has a mask of the letters of its children, so the child for the ith letter (if it
+ * exists) is at index `first + popcount(mask & ((1 << i) - 1))`.
+ *
+ * Each node also summarises the words that continue past it, so that a search can give up on a node without visiting
+ * any of its children.
+ */
+typedef struct DictNode {
+  uint32_t mask; // bit i is set if there is a child for the ith letter, along with DICT_TERMINAL for the end of a word
+  uint32_t first; // index of the first child
+  uint32_t reachable; // bit i is set if the ith letter appears anywhere after this node in a word
+  uint8_t min_remaining; // fewest letters needed after this node to finish a longer word (0 if there are none)
+  uint8_t max_score; // highest total score of the letters after this node in any word (at most DICT_MAX_SCORE)
+  uint8_t reserved[2]; // always 0
+} DictNode;
+
+
+/**
+ * Header at the start of a dictionary file, which is immediately followed by the array of nodes.
+ */
+typedef struct DictHeader {
+  char magic[8]; // DICT_MAGIC
+  uint32_t byte_order; // DICT_BYTE_ORDER
+  uint32_t version; // DICT_VERSION
+  uint32_t num_nodes; // number of nodes following the header
+  uint32_t checksum; // FNV-1a hash of the nodes
+} DictHeader;
+
+
+/**
+ * A read-only dictionary, stored as a flattened trie.
+ */
+typedef struct Dict {
+  const DictNode *nodes; // array of nodes, with the root at index 0
+  uint32_t num_nodes; // number of nodes in the array
+
+  DictNode *storage; // memory owned by the dictionary (NULL for static data)
+  void *map; // mapped dictionary file (NULL if not loaded from a file)
+  size_t map_size; // size of the mapped file
+} Dict;
+
+
+/**
+ * Flatten a trie into a dictionary.
+ *
+ * @param dict pointer to the dictionary to set up (free with dict_free)
+ * @param root pointer to the root node of the trie
+ * @param scores the score of each letter, used to bound the score of the words below each node
+ * @return 0 on success, 1 on failure (due to failed malloc)
+ */
+int dict_from_trie(Dict *dict, const Trie *root, const char scores[26]);
+
+
+/**
+ * Open a dictionary file.
+ *
+ * The file is mapped read-only and used in place, so there is no parsing or copying and processes using the same file
+ * share a single copy of it. The header and checksum are verified before the dictionary is used.
+ *
+ * @param dict pointer to the dictionary to set up (free with dict_free)
+ * @param path the file to open
+ * @return 0 on success, 1 if the file could not be read, 2 if it is not a compatible dictionary, 3 if it is corrupt
+ */
+int dict_open(Dict *dict, const char *path);
+
+
+/**
+ * Write a dictionary to a file that can be loaded with dict_open.
+ *
+ * @param dict pointer to the dictionary
+ * @param path the file to write to
+ * @return 0 on success, 1 on failure
+ */
+int dict_write(const Dict *dict, const char *path);
+
+
+/**
+ * Get a checksum of a dictionary, to tell whether data derived from it is still valid.
+ *
+ * @param dict pointer to the dictionary
+ * @return the FNV-1a hash of the nodes (the same as stored in a dictionary file)
+ */
+uint32_t dict_checksum(const Dict *dict);
+
+
+/**
+ * Free any memory owned by a dictionary, unmapping it if it was loaded from a file.
+ *
+ * @param dict pointer to the dictionary
+ */
+void dict_free(Dict *dict);
+
+
+/**
+ * Step from a node to one of its children.
+ *
+ * The root of the dictionary is node 0, so a word can be followed one letter at a time without starting from the root
+ * again for each prefix.
+ *
+ * @param dict pointer to the dictionary
+ * @param node the index of the node
+ * @param ch the letter of the child
+ * @return the index of the child, or DICT_NONE if there is no such child
+ */
+uint32_t dict_step(const Dict *dict, uint32_t node, char ch);
+
+
+/**
+ * Check if a node is the end of a word.
+ *
+ * @param dict pointer to the dictionary
+ * @param node the index of the node
+ * @return 1 if the node is the end of a word, 0 otherwise
+ */
+int dict_is_word(const Dict *dict, uint32_t node);
+
+
+/**
+ * Check if any words continue past a node.
+ *
+ * @param dict pointer to the dictionary
+ * @param node the index of the node
+ * @return 1 if the node has any children, 0 otherwise
+ */
+int dict_has_children(const Dict *dict, uint32_t node);
+
+
+/**
+ * Get the letters that appear in any word continuing past a node.
+ *
+ * @param dict pointer to the dictionary
+ * @param node the index of the node
+ * @return a mask with bit i set if the ith letter is reachable from the node
+ */
+uint32_t dict_reachable_letters(const Dict *dict, uint32_t node);
+
+
+/**
+ * Get the fewest letters that must be added after a node to reach another word.
+ *
+ * @param dict pointer to the dictionary
+ * @param node the index of the node
+ * @return the minimum number of letters, or 0 if no words continue past the node
+ */
+int dict_min_remaining(const Dict *dict, uint32_t node);
+
+
+/**
+ * Get the highest score that the letters after a node can add to a word.
+ *
+ * Bounds larger than DICT_MAX_SCORE are clamped, so are only reliable for words that cannot score that many points.
+ *
+ * @param dict pointer to the dictionary
+ * @param node the index of the node
+ * @return the maximum score of any completion, or 0 if no words continue past the node
+ */
+int dict_max_score(const Dict *dict, uint32_t node);
+
+
+/**
+ * List the words in a dictionary, in alphabetical order.
+ *
+ * @param dict pointer to the dictionary
+ * @param max_len the length of the longest words to list
+ * @param words set to an array of the words, each taking up max_len + 1 chars (free with free)
+ * @param num_words set to the number of words listed
+ * @return 0 on success, 1 on failure (due to failed malloc)
+ */
+int dict_list_words(const Dict *dict, int max_len, char **words, uint32_t *num_words);
+
+
+/**
+ * Check if a word is in the dictionary.
+ *
+ * @param dict pointer to the dictionary
+ * @param word the word to find (null-terminated string)
+ * @param prefix whether to count a prefix as valid (1) or a require full word match (0)
+ * @return 1 if the word is in the dictionary, 0 otherwise
+ */
+int dict_contains(const Dict *dict, const char *word, int prefix);
+
+
+#endif //DICT_H
@@ -7,93 +7,25 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "src/core/board_2048.h"
+
 
 /**
- * Perform a single move/merge step
+ * Draw a random number for adding a tile.
  *
- * @param game The game state.
- * @param move The move to perform.
- * @return 0 if no move was made, 1 otherwise.
+ * @param game The game state, whose generator is used (or rand if it has none).
+ * @param n The number of possible values.
+ * @return A number from 0 to n - 1.
  */
-static int movemerge(struct Game *game, const Move move) {
-  int has_moved = 0;
-
-  /* set up the loops depending on the move direction */
-  int i0 = 0, i1 = 0, j0 = 0, j1 = 0, di = 0, dj = 0, d = 0;
-  switch (move) {
-    case UP:
-      i0 = 0;
-      i1 = SIZE - 1;
-      di = 1; // bottom to top
-      j0 = 0;
-      j1 = SIZE;
-      dj = 1; // left to right
-      d = SIZE; // next row
-      break;
-    case LEFT:
-      i0 = 0;
-      i1 = SIZE;
-      di = 1; // bottom to top
-      j0 = 0;
-      j1 = SIZE - 1;
-      dj = 1; // left to right
-      d = 1; // next column
-      break;
-    case DOWN:
-      i0 = SIZE - 1;
-      i1 = 0;
-      di = -1; // top to bottom
-      j0 = SIZE - 1;
-      j1 = -1;
-      dj = -1; // right to left
-      d = -SIZE; // previous row
-      break;
-    case RIGHT:
-      i0 = SIZE - 1;
-      i1 = -1;
-      di = -1; // top to bottom
-      j0 = SIZE - 1;
-      j1 = 0;
-      dj = -1; // right to left
-      d = -1; // previous column
-      break;
+static int random_below(struct Game *game, const int n) {
+  if (!game->rng) {
+    return rand() % n;
   }
 
-  /* move/merge cycle */
-  for (int i = i0; i != i1; i += di) {
-    for (int j = j0; j != j1; j += dj) {
-      int *cell = game->grid + j + SIZE * i;
-      int *mcell = game->merge + j + SIZE * i;
-
-      /* empty space: move into it */
-      if (*cell == 0) {
-        if (*(cell + d) != 0) {
-          *cell = *(cell + d);
-          *mcell = *(mcell + d);
-
-          *(cell + d) = 0;
-          *(mcell + d) = 0;
-
-          has_moved = 1;
-        }
-      }
-
-      /* match next: merge into it */
-      else if ((*cell == *(cell + d)) && (*mcell == 0) && (*(mcell + d) == 0)) {
-        *cell += 1;
-        *mcell = 1;
-        game->score += (1 << *cell) * (*cell - 1);
-        game->nz++;
-
-        *(cell + d) = 0;
-        *(mcell + d) = 0;
-
-        has_moved = 1;
-      }
-    } // j end
-  } // i end
-
-  return has_moved;
+  game->rng ^= game->rng << 13;
+  game->rng ^= game->rng >> 7;
+  game->rng ^= game->rng << 17;
+  return (int) ((game->rng >> 32) % (uint64_t) n);
 }
 
 
@@ -105,7 +37,7 @@ static int movemerge(struct Game *game, const Move move) {
  */
 static int fill_random_cell(struct Game *game) {
   /* choose a random empty cell */
-  int n = rand() % game->nz;
+  int n = random_below(game, game->nz);
   game->nz--;
 
   /* insert 2 or 4 into the grid */
@@ -114,7 +46,7 @@ static int fill_random_cell(struct Game *game) {
       /* reached the selected cell */
       if (n == 0) {
         /* 90% change of a 2, 10% change of a 4 */
-        if (rand() % 10) {
+        if (random_below(game, 10)) {
           game->grid[i] = 1;
         } else {
           game->grid[i] = 2;
@@ -167,7 +99,43 @@ static void set_status(struct Game *game) {
 }
 
 
-void reset_2048(struct Game *game) {
+int slide_line_2048(int *line, const int stride, int *score) {
+  int has_moved = 0;
+  int filled = 0; // number of cells filled so far from the start of the line
+  int can_merge = 0; // whether the last filled cell can still take a merge
+
+  for (int i = 0; i < SIZE; i++) {
+    const int tile = line[i * stride];
+    if (tile == 0) {
+      continue;
+    }
+    line[i * stride] = 0;
+
+    /* merge into the last tile if it matches (and has not already merged), otherwise move up behind it */
+    if (can_merge && line[(filled - 1) * stride] == tile) {
+      const int merged = tile + 1;
+      line[(filled - 1) * stride] = merged;
+      *score += (1 << merged) * (merged - 1);
+      can_merge = 0;
+      has_moved = 1;
+    } else {
+      line[filled * stride] = tile;
+      has_moved |= filled != i;
+      filled++;
+      can_merge = 1;
+    }
+  }
+
+  return has_moved;
+}
+
+
+/**
+ * Start a new game, once the generator has been chosen.
+ *
+ * @param game The game state.
+ */
+static void start_game(struct Game *game) {
   game->score = 0;
   game->turn = 0;
   game->status = PLAYING;
@@ -182,22 +150,76 @@ void reset_2048(struct Game *game) {
 }
 
 
+void reset_2048(struct Game *game) {
+  game->rng = 0;
+  start_game(game);
+}
+
+
+void reset_seeded_2048(struct Game *game, const uint64_t seed) {
+  /* spread out nearby seeds, avoiding the zero state that xorshift never leaves */
+  game->rng = (seed + 1) * 0x9E3779B97F4A7C15ull;
+  if (!game->rng) {
+    game->rng = 1;
+  }
+  start_game(game);
+}
+
+
 Result move_2048(struct Game *game, const Move move) {
-  memset(game->merge, 0, SIZE*SIZE*sizeof(game->merge[0])); // reset merge info
-
-  /* move/merge until no more moves/merges are possible */
-  int total_cycles = 0;
-  int has_moved;
-  do {
-    has_moved = movemerge(game, move);
-    total_cycles += has_moved;
-  } while (has_moved);
-
-  /* no cycles performed means the move did nothing */
-  if (total_cycles == 0) {
+  /* move whole rows at a time with the bitboard tables, unless a tile is too big for them */
+  if (board_fits(game->grid)) {
+    const Board board = board_from_grid(game->grid);
+    Board moved;
+    int score;
+    if (!board_move(board, move, &moved, &score)) {
+      if (moved == board) {
+        return MOVE_ERROR;
+      }
+
+      board_to_grid(moved, game->grid);
+      game->score += score;
+      game->nz = board_count_empty(moved);
+      return MOVE_SUCCESS;
+    }
+  }
+
+  /* otherwise slide each line in a single pass, starting from the edge the tiles move towards */
+  int has_moved = 0;
+  for (int k = 0; k < SIZE; k++) {
+    int start = 0, stride = 0;
+    switch (move) {
+      case UP:
+        start = k; // top of column k
+        stride = SIZE;
+        break;
+      case DOWN:
+        start = k + SIZE * (SIZE - 1); // bottom of column k
+        stride = -SIZE;
+        break;
+      case LEFT:
+        start = SIZE * k; // left of row k
+        stride = 1;
+        break;
+      case RIGHT:
+        start = SIZE * k + SIZE - 1; // right of row k
+        stride = -1;
+        break;
+    }
+
+    has_moved |= slide_line_2048(game->grid + start, stride, &game->score);
+  }
+
+  if (!has_moved) {
     return MOVE_ERROR;
   }
 
+  /* merges free up cells */
+  game->nz = 0;
+  for (int i = 0; i < SIZE * SIZE; i++) {
+    game->nz += game->grid[i] == 0;
+  }
+
   return MOVE_SUCCESS;
 }
 
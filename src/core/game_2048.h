@@ -5,6 +5,8 @@
 #ifndef GAME_2048_H
 #define GAME_2048_H
 
+#include <stdint.h>
+
 #define SIZE (4) // size of the grid
 
 
@@ -48,7 +50,7 @@ struct Game {
   GameStatus status; // game status
 
   int nz; // number of zero cells
-  int merge[SIZE * SIZE]; // merging info
+  uint64_t rng; // state of the xorshift generator used to add tiles (0 to use rand)
 };
 
 
@@ -60,6 +62,32 @@ struct Game {
 void reset_2048(struct Game *game);
 
 
+/**
+ * Reset the game state, with tiles added by the game's own generator instead of rand.
+ *
+ * The same seed always gives the same tiles for the same moves, and games with their own generators can be played on
+ * several threads at once. Resetting with reset_2048 goes back to using rand.
+ *
+ * @param game The game state.
+ * @param seed The seed of the generator.
+ */
+void reset_seeded_2048(struct Game *game, uint64_t seed);
+
+
+/**
+ * Slide a single line of tiles towards its start, merging any matching pairs.
+ *
+ * Each tile merges at most once per move, with the tile nearest the start merging first (so 2 2 2 becomes 4 2). The
+ * line is compacted and merged in one pass, in place.
+ *
+ * @param line The first cell of the line (the end the tiles move towards), holding powers of 2.
+ * @param stride The distance between cells of the line (negative to run backwards through the grid).
+ * @param score Incremented by the score gained from the merges.
+ * @return 1 if any tile moved or merged, 0 otherwise.
+ */
+int slide_line_2048(int *line, int stride, int *score);
+
+
 /**
  * Move the tiles in the given direction.
  *
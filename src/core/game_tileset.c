@@ -5,12 +5,18 @@
 #include "game_tileset.h"
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
+#include <unistd.h>
 
-#include "src/wordlists/en-gb.h"
-#include "src/core/trie.h"
+#include "src/core/anagram.h"
+#include "src/core/dict.h"
+#include "src/core/histogram.h"
+#include "src/core/table.h"
+#include "obj/en-gb-dict.h" // generated by src/tools/mkdict.c
 
 
 // Check that the alphabet is contiguous
@@ -50,8 +56,113 @@ static const char LETTERS[100] = {
 
 
 // Scores for each letter
-static const char SCORES[26] = {1, 3, 3, 2, 1, 4, 2, 4, 1, 8, 5, 1, 3, 1, 1, 3, 10, 1, 1, 1, 1, 4, 4, 8, 4, 10,};
-//                              a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p,  q, r, s, t, u, v, w, x, y,  z
+static const char SCORES[26] = LETTER_SCORES;
+
+// Check that the built-in dictionary was pruned for a rack of this size (mkdict --rack), so that it has every word that
+// fits in a rack and no longer ones
+#if EN_GB_DICT_LENGTH_LIMIT && EN_GB_DICT_LENGTH_LIMIT != SIZE
+#error "the built-in dictionary was pruned for a different rack size, rebuild it with mkdict --rack"
+#endif
+static_assert(EN_GB_DICT_MAX_LEN >= SIZE, "the dictionary was pruned to words shorter than the rack");
+
+// Check that the best score of any word fits in the bound stored by each dictionary node
+static_assert(SIZE * MAX_LETTER_SCORE < DICT_MAX_SCORE, "dictionary score bounds are too small for the rack");
+
+
+#define CACHE_BUCKETS (2 * CACHE_SIZE) // number of hash chains used to find a rack in the cache
+#define CACHE_MAGIC ("PZLCACH") // identifies a cache file (including the null-terminator)
+#define CACHE_VERSION (1) // bumped whenever the layout of a cache file changes
+
+
+/**
+ * Best words for a single rack.
+ */
+struct CacheRecord {
+  char rack[SIZE + 1]; // the letters of the rack in sorted order, so that the order of the tiles does not matter
+  char top_words[STORE][SIZE + 1]; // best words, from best to worst
+  int top_scores[STORE]; // scores of the best words
+};
+
+
+/**
+ * Header at the start of a cache file, which is followed by any number of records.
+ */
+struct CacheHeader {
+  char magic[8]; // CACHE_MAGIC
+  uint32_t version; // CACHE_VERSION
+  uint32_t size; // SIZE
+  uint32_t store; // STORE
+  uint32_t dict_checksum; // checksum of the dictionary used to find the best words
+};
+
+
+/**
+ * Position of a rack's record in the cache file.
+ */
+struct CacheSlot {
+  char rack[SIZE + 1]; // the sorted letters of the rack (empty for an unused slot)
+  uint32_t record; // index of the record in the file, after the header
+};
+
+
+/**
+ * Least recently used cache of the best words for each rack, optionally backed by a file.
+ *
+ * The file holds every rack solved so far, and is indexed in memory by rack so that a rack dropped from the least
+ * recently used records can be read back from the file rather than searched for again.
+ */
+struct Cache {
+  pthread_mutex_t lock; // held while using the cache
+
+  struct CacheRecord records[CACHE_SIZE]; // the cached racks
+  int chain[CACHE_SIZE]; // next record in the same hash chain (-1 for none)
+  int newer[CACHE_SIZE]; // next more recently used record (-1 for none)
+  int older[CACHE_SIZE]; // next less recently used record (-1 for none)
+  int buckets[CACHE_BUCKETS]; // first record in each hash chain (-1 for none)
+  int newest; // most recently used record (-1 for none)
+  int oldest; // least recently used record (-1 for none)
+  int count; // number of records in use
+  int is_ready; // whether the links have been set up
+
+  FILE *fp; // file that new records are appended to (NULL if none)
+  struct CacheSlot *slots; // open-addressed hash table of every rack in the file (NULL if none)
+  uint32_t num_slots; // number of slots in the table (a power of 2)
+  uint32_t num_records; // number of records in the file
+
+  int hits; // number of racks found in the cache
+  int misses; // number of racks that had to be solved
+};
+
+
+// Flattened prefix tree of every word in the dictionary, shared between games
+static const Dict *DICTIONARY = NULL;
+
+// Dictionary mapped from a file, used in place of the built-in one when opened
+static Dict FILE_DICTIONARY;
+
+// Precomputed best words for every rack, used in place of searching when opened
+static Table TABLE;
+
+// Number of threads used to find the best words in each rack
+static int NUM_THREADS = 1;
+
+// How the best words in each rack are found
+static Solver SOLVER = SOLVER_TRIE;
+
+// Words of the dictionary indexed by their letters, built when the anagram solver is first used
+static Anagram ANAGRAMS;
+
+// Letter counts of every word in the dictionary, built when the histogram solver is first used
+static Histogram HISTOGRAMS;
+
+// How the letter counts are scanned by the histogram solver
+static HistogramBackend HISTOGRAM_BACKEND = HISTOGRAM_AUTO;
+
+// Held while building or freeing the solver indexes, which may first be needed by a background search
+static pthread_mutex_t INDEXES_LOCK = PTHREAD_MUTEX_INITIALIZER;
+
+// Best words for recently solved racks, shared between threads
+static struct Cache CACHE = {.lock = PTHREAD_MUTEX_INITIALIZER};
 
 
 /**
@@ -99,109 +210,391 @@ int parse_seed(char *letters, const char *seed) {
 
 
 /**
- * Depth-first search of the trie, finding the best words.
+ * State of a search for the best words that can be made from a rack.
+ *
+ * The rack is held as a count of each letter rather than as a list of tiles, so that repeated letters (and blanks) are
+ * only tried once at each position in a word.
+ */
+struct Search {
+  const Dict *dict; // the dictionary to search
+  struct Game *game; // the game state, holding the list of best words
+  int counts[27]; // number of tiles left for each letter, with the blanks last
+  char word[SIZE + 1]; // the current prefix (always null-terminated)
+  const int *cancel; // set by another thread to stop the search early (NULL if it cannot be cancelled)
+};
+
+
+/**
+ * Background search for the best words in a rack.
+ */
+struct SolveTask {
+  struct Game game; // copy of the game being solved, which receives the best words
+  int cancel; // set to stop the search early
+  int done; // set once the search has finished
+  pthread_t thread; // the thread running the search
+};
+
+
+/**
+ * Upcoming rack, drawn and solved ahead of time.
+ */
+struct Prefetch {
+  uint64_t rng; // state of the xorshift generator used to draw each rack
+  char letters[SIZE + 1]; // letters of the next rack
+  struct SolveTask *task; // search for the best words in the next rack (NULL if it could not be started)
+  int is_waiting; // whether the search for the next rack waits for the one handed over on a miss (see resume)
+
+  int hits; // number of racks that were already solved when they were needed
+  int misses; // number of racks that were still being solved
+};
+
+
+/**
+ * State of a thread searching part of a rack.
+ */
+struct Worker {
+  struct Search search; // the search state, pointing to this worker's own game
+  struct Game game; // holds the best words found by this worker
+  int *next_letter; // the next first letter to search, shared between workers
+  pthread_t thread; // the thread running the worker
+};
+
+
+/**
+ * Check if the tiles that are left could possibly extend a prefix into a longer word.
+ *
+ * This only rules out nodes that are certainly dead ends: there must be enough tiles left for the shortest word below
+ * the node, and without any blanks at least one of the remaining letters must appear somewhere below it.
+ *
+ * @param search the search state
+ * @param node the dictionary node reached by the prefix
+ * @param len the length of the prefix
+ * @return 1 if a longer word might be made, 0 otherwise
+ */
+static int can_extend(const struct Search *search, const uint32_t node, const int len) {
+  if (SIZE - len < dict_min_remaining(search->dict, node)) {
+    return 0;
+  }
+
+  if (search->counts[26]) {
+    return 1;
+  }
+
+  uint32_t letters = 0;
+  for (int k = 0; k < 26; k++) {
+    if (search->counts[k]) {
+      letters |= 1u << k;
+    }
+  }
+
+  return (dict_reachable_letters(search->dict, node) & letters) != 0;
+}
+
+
+/**
+ * Check if a search has been asked to stop early.
+ *
+ * @param search the search state
+ * @return 1 if the search should stop, 0 otherwise
+ */
+static int is_cancelled(const struct Search *search) {
+  return search->cancel && __atomic_load_n(search->cancel, __ATOMIC_RELAXED);
+}
+
+
+/**
+ * Get the lowest score in the list of best words, which any new word has to at least match to get in.
+ *
+ * @param game the game state
+ * @return the lowest of the top scores (0 while the list has any gaps)
+ */
+static int worst_top_score(const struct Game *game) {
+  int worst_score = game->top_scores[0];
+  for (int j = 1; j < STORE; j++) {
+    if (game->top_scores[j] < worst_score) {
+      worst_score = game->top_scores[j];
+    }
+  }
+
+  return worst_score;
+}
+
+
+/**
+ * Add a word to the list of best words, if it is better than the worst of them.
  *
- * @param root the root of the trie
  * @param game the game state
- * @param prefix the current prefix
- * @param used the letters that have been used
+ * @param word the word to add
+ * @param score the score of the word
+ */
+static void add_top_word(struct Game *game, const char *word, const int score) {
+  /* find the worst of the current best words */
+  int worst_index = 0;
+  for (int j = 1; j < STORE; j++) {
+    if (
+      game->top_scores[j] < game->top_scores[worst_index] ||
+      (game->top_scores[j] == game->top_scores[worst_index] &&
+       strncmp(game->top_words[j], game->top_words[worst_index], SIZE) > 0)
+    ) {
+      worst_index = j;
+    }
+  }
+
+  /* replace it with this one if it is better (or the same and lower alphabetically) */
+  if (
+    score > game->top_scores[worst_index] ||
+    (score == game->top_scores[worst_index] && strncmp(word, game->top_words[worst_index], SIZE) < 0)
+  ) {
+    game->top_scores[worst_index] = score;
+    memcpy(game->top_words[worst_index], word, SIZE);
+  }
+}
+
+
+/**
+ * Depth-first search of the trie below one letter added to a prefix, finding the best words.
+ *
+ * Each letter is tried once at each position, using a real tile if there is one left and a blank otherwise. Using the
+ * real tile first never rules out a word (the blank can stand in for that letter later instead) and always scores the
+ * most, so the score of each word is settled by the time it is reached. Branches are cut off once even the highest
+ * scoring word below them could not make it into the list of best words.
+ *
+ * @param search the search state, with the current prefix in search->word
+ * @param node the dictionary node reached by the current prefix
  * @param len the length of the prefix
+ * @param prefix_score the score of the prefix
+ * @param k the index of the letter to add to the prefix
  */
-static void depth_first_search(
-  Trie *root, struct Game *game, const char prefix[SIZE + 1], const char used[SIZE + 1], const int len
-) {
-  for (int i = 0; i < SIZE; i++) {
-    if (used[i]) {
-      continue;
+static void search_letter(struct Search *search, const uint32_t node, const int len, const int prefix_score, const int k) {
+  /* pick the tile to use for this letter */
+  int tile = k;
+  if (!search->counts[k]) {
+    tile = 26;
+    if (!search->counts[tile]) {
+      return;
     }
+  }
 
-    /* set up the possible letters the letters[i] could be */
-    char alphabet[26] = {
-      'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm',
-      'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z',
-    };
-    if (game->letters[i] != BLANK) {
-      alphabet[0] = game->letters[i];
-      alphabet[1] = '\0';
+  /* only carry on if the prefix can be extended with this letter, and might still score enough */
+  const char letter = (char) ('a' + k);
+  const uint32_t child = dict_step(search->dict, node, letter);
+  if (child == DICT_NONE) {
+    return;
+  }
+
+  const int score = prefix_score + (tile == k ? SCORES[k] : 0);
+  const int cutoff = worst_top_score(search->game);
+  if (score + dict_max_score(search->dict, child) < cutoff) {
+    return;
+  }
+
+  search->counts[tile]--;
+  search->word[len] = letter;
+  search->word[len + 1] = '\0';
+
+  /* check if this prefix is a real word */
+  if (dict_is_word(search->dict, child) && score >= cutoff) {
+    add_top_word(search->game, search->word, score);
+  }
+
+  /* try to continue with more letters if any words start with this prefix that the remaining tiles could make */
+  if (dict_has_children(search->dict, child) && can_extend(search, child, len + 1)) {
+    for (int next = 0; next < 26; next++) {
+      search_letter(search, child, len + 1, score, next);
     }
+  }
 
-    for (int k = 0; k < 26; k++) {
-      if (alphabet[k] == '\0') {
-        break;
-      }
+  search->word[len] = '\0';
+  search->counts[tile]++;
+}
 
-      /* duplicate the input arguments */
-      char newPrefix[SIZE + 1] = {0};
-      char newPrefixBlank[SIZE + 1] = {0}; // newPrefix using the blank tile (if it exists)
-      char newUsed[SIZE + 1] = {0};
-      memcpy(newPrefix, prefix, len);
-      memcpy(newPrefixBlank, prefix, len);
-      memcpy(newUsed, used, SIZE);
-
-      /* add the letter to the end of the prefix */
-      newUsed[i] = 1;
-      newPrefix[len] = alphabet[k]; // newPrefix can never have a blank in it since we use it to check the dictionary
-      newPrefix[len + 1] = '\0';
-      newPrefixBlank[len] = game->letters[i]; // newPrefixBlank
-      newPrefixBlank[len + 1] = '\0';
-
-      /* previous letters might also have been a blank, so replace them */
-      for (int j = 0; j < len; j++) {
-        int is_blank = 1;
-        for (int p = 0; p < SIZE; p++) {
-          if (used[p] && game->letters[p] == newPrefix[j]) {
-            is_blank = 0;
-            break;
-          }
-        }
 
-        if (is_blank) {
-          newPrefixBlank[j] = BLANK;
-        }
-      }
+/**
+ * Find the best words in a rack by looking up every set of letters it could make in the anagram index.
+ *
+ * The letters are chosen in alphabetical order, taking each letter any number of times that the real tiles (then the
+ * blanks) allow, so each set of letters is only looked up once and always scores as much as it can. This makes at most
+ * 2^SIZE lookups without blanks, and a few thousand more for each blank.
+ *
+ * @param search the search state
+ * @param index the anagram index of the dictionary
+ * @param word_counts the number of each letter chosen so far
+ * @param k the index of the next letter to choose
+ * @param len the number of letters chosen so far
+ * @param score the score of the letters chosen so far
+ */
+static void search_anagrams(struct Search *search, const Anagram *index, int word_counts[26], const int k,
+                            const int len, const int score) {
+  if (is_cancelled(search)) {
+    return;
+  }
 
-      /* check if this prefix is a real word */
-      if (trie_contains(root, newPrefix, 0)) {
-        /* don't bother adding words that are already in the lists */
-        int is_new = 1;
-        for (int j = 0; j < STORE; j++) {
-          if (!strncmp(game->top_words[j], newPrefix, SIZE)) {
-            is_new = 0;
-            break;
-          }
-        }
+  /* look up the words made from exactly these letters */
+  if (k == 26) {
+    uint32_t count;
+    const char *words = anagram_find(index, anagram_signature(word_counts), &count);
+    for (uint32_t i = 0; i < count; i++) {
+      add_top_word(search->game, words + (size_t) i * (SIZE + 1), score);
+    }
+    return;
+  }
+
+  /* try each number of this letter, using the real tiles before any blanks */
+  const int real = search->counts[k];
+  for (int c = 0; len + c <= SIZE; c++) {
+    const int blanks = c > real ? c - real : 0;
+    if (blanks > search->counts[26]) {
+      break;
+    }
+
+    word_counts[k] = c;
+    search->counts[26] -= blanks;
+    search_anagrams(search, index, word_counts, k + 1, len + c, score + (c - blanks) * SCORES[k]);
+    search->counts[26] += blanks;
+  }
+  word_counts[k] = 0;
+}
+
+
+/**
+ * Find the best words in a rack by checking the letter counts of every word in the dictionary against it.
+ *
+ * @param search the search state
+ * @param index the letter counts of every word
+ */
+static void search_histograms(struct Search *search, const Histogram *index) {
+  uint8_t rack[HISTOGRAM_WIDTH] = {0};
+  for (int k = 0; k < 26; k++) {
+    rack[k] = (uint8_t) search->counts[k];
+  }
 
-        if (is_new) {
-          /* find the worst of the current best words */
-          int worst_score = 10000000;
-          int worst_index = 0;
-          for (int j = 0; j < STORE; j++) {
-            if (
-              game->top_scores[j] < worst_score ||
-              (game->top_scores[j] == worst_score && strncmp(game->top_words[j], game->top_words[worst_index], SIZE) >
-               0)
-            ) {
-              worst_score = game->top_scores[j];
-              worst_index = j;
-            }
-          }
-
-          /* replace it with this one if it is better (or the same and lower alphabetically) */
-          const int score = score_word_tileset(game, newPrefixBlank);
-          if (
-            score > worst_score ||
-            (score == worst_score && strncmp(newPrefix, game->top_words[worst_index], SIZE) < 0)
-          ) {
-            game->top_scores[worst_index] = score;
-            memcpy(game->top_words[worst_index], newPrefix, SIZE);
-          }
+  /* scan a block of words at a time, then score the ones that can be made */
+  uint32_t matches[1024];
+  for (uint32_t first = 0; first < index->num_words && !is_cancelled(search); first += 1024) {
+    const uint32_t last = first + 1024 < index->num_words ? first + 1024 : index->num_words;
+    const uint32_t n = histogram_match(index, HISTOGRAM_BACKEND, rack, search->counts[26], first, last, matches);
+
+    for (uint32_t i = 0; i < n; i++) {
+      const char *word = index->words + (size_t) matches[i] * (SIZE + 1);
+
+      // use the real tiles before any blanks
+      int left[26];
+      memcpy(left, search->counts, sizeof(left));
+      int score = 0;
+      for (int j = 0; word[j] != '\0'; j++) {
+        const int k = word[j] - 'a';
+        if (left[k]) {
+          left[k]--;
+          score += SCORES[k];
         }
-      } else if (!trie_contains(root, newPrefix, 1)) {
-        continue;
       }
 
-      /* try to continue with more letters since this is a valid prefix */
-      depth_first_search(root, game, newPrefix, newUsed, len + 1);
+      add_top_word(search->game, word, score);
+    }
+  }
+}
+
+
+/**
+ * Build the anagram index of the dictionary, if it has not been built already.
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+static int load_anagrams(void) {
+  if (load_dictionary_tileset()) {
+    return 1;
+  }
+
+  pthread_mutex_lock(&INDEXES_LOCK);
+  int err = 0;
+  if (!ANAGRAMS.words) {
+    err = anagram_from_dict(&ANAGRAMS, DICTIONARY, SIZE);
+  }
+  pthread_mutex_unlock(&INDEXES_LOCK);
+
+  return err;
+}
+
+
+/**
+ * Build the letter counts of every word in the dictionary, if they have not been built already.
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+static int load_histograms(void) {
+  if (load_dictionary_tileset()) {
+    return 1;
+  }
+
+  pthread_mutex_lock(&INDEXES_LOCK);
+  int err = 0;
+  if (!HISTOGRAMS.words) {
+    err = histogram_from_dict(&HISTOGRAMS, DICTIONARY, SIZE);
+  }
+  pthread_mutex_unlock(&INDEXES_LOCK);
+
+  return err;
+}
+
+
+/**
+ * Work through the first letters of the words in a rack, until there are none left.
+ *
+ * @param arg pointer to the worker's state
+ * @return NULL
+ */
+static void *solve_worker(void *arg) {
+  struct Worker *worker = arg;
+
+  while (!is_cancelled(&worker->search)) {
+    const int k = __atomic_fetch_add(worker->next_letter, 1, __ATOMIC_RELAXED);
+    if (k >= 26) {
+      break;
+    }
+
+    search_letter(&worker->search, 0, 0, 0, k);
+  }
+
+  return NULL;
+}
+
+
+/**
+ * Find the best words in a rack on several threads, with each thread taking whole first letters at a time.
+ *
+ * Each thread keeps its own list of best words, which are merged at the end. Since words are ranked by score then
+ * alphabetically, the merged list is the same however the letters were shared out.
+ *
+ * @param search the search state to start from
+ * @param num_threads the number of threads to use (including this one)
+ */
+static void solve_parallel(const struct Search *search, const int num_threads) {
+  struct Worker workers[MAX_THREADS];
+  int next_letter = 0;
+  for (int t = 0; t < num_threads; t++) {
+    workers[t].search = *search;
+    workers[t].search.game = &workers[t].game;
+    workers[t].next_letter = &next_letter;
+    memset(&workers[t].game, 0, sizeof(struct Game));
+  }
+
+  /* this thread works too, and picks up any letters left over if a thread fails to start */
+  int started[MAX_THREADS] = {0};
+  for (int t = 1; t < num_threads; t++) {
+    started[t] = !pthread_create(&workers[t].thread, NULL, solve_worker, &workers[t]);
+  }
+  solve_worker(&workers[0]);
+
+  /* merge the best words from each thread */
+  for (int t = 0; t < num_threads; t++) {
+    if (started[t]) {
+      pthread_join(workers[t].thread, NULL);
+    }
+
+    for (int j = 0; j < STORE; j++) {
+      if (workers[t].game.top_words[j][0] != '\0') {
+        add_top_word(search->game, workers[t].game.top_words[j], workers[t].game.top_scores[j]);
+      }
     }
   }
 }
@@ -253,124 +646,676 @@ int score_word_tileset(const struct Game *game, const char *word) {
 }
 
 
-int reset_tileset(struct Game *game, const char *seed, const int get_top_words) {
-  game->score = 0;
-  memset(game->top_scores, 0, STORE * sizeof(int));
-  memset(game->has_found, 0, STORE * sizeof(int));
-  for (int i = 0; i < STORE; i++) {
-    memset(game->top_words[i], 0, SIZE + 1);
+int load_dictionary_tileset(void) {
+  /* the prefix tree is flattened at build time, so there is nothing to construct */
+  if (!DICTIONARY) {
+    DICTIONARY = &EN_GB_DICT;
   }
 
-  if (seed) {
-    /* set indices into the letters array from the seed */
-    if (parse_seed(game->letters, seed)) {
-      return 1;
-    }
-  } else {
-    /* pick random indices into the LETTERS array, not allowing replacement */
-    for (int i = 0; i < SIZE; i++) {
-      int redraw;
-      do {
-        // get a random index
-        game->letters[i] = rand() % 100;
-
-        // check if the letter is already in the shuffle
-        redraw = 0;
-        for (int j = 0; j < i; j++) {
-          if (game->letters[i] == game->letters[j]) {
-            redraw = 1;
-            break;
-          }
-        }
-      } while (redraw);
-    }
-  }
+  return 0;
+}
 
-  /* convert indices into letters */
-  for (int i = 0; i < SIZE; i++) {
-    game->letters[i] = LETTERS[(unsigned char) game->letters[i]];
-  }
-  game->letters[SIZE] = '\0'; // ensure the string is null-terminated
 
-  if (get_top_words) {
-    top_words_tileset(game);
+int open_dictionary_tileset(const char *path) {
+  free_dictionary_tileset();
+
+  if (dict_open(&FILE_DICTIONARY, path)) {
+    return 1;
   }
+  DICTIONARY = &FILE_DICTIONARY;
 
   return 0;
 }
 
 
-void shuffle_tileset(struct Game *game) {
-  // Perform a Fisher-Yates shuffle
-  for (int i = 0; i < SIZE - 1; i++) {
-    const int j = i + rand() / (RAND_MAX / (SIZE - i) + 1);
-    const char tmp = game->letters[j];
-    game->letters[j] = game->letters[i];
-    game->letters[i] = tmp;
+void free_dictionary_tileset(void) {
+  /* the cached and precomputed best words (and the solver indexes) came from this dictionary */
+  clear_cache_tileset();
+  free_table_tileset();
+  pthread_mutex_lock(&INDEXES_LOCK);
+  anagram_free(&ANAGRAMS);
+  histogram_free(&HISTOGRAMS);
+  pthread_mutex_unlock(&INDEXES_LOCK);
+
+  if (DICTIONARY == &FILE_DICTIONARY) {
+    dict_free(&FILE_DICTIONARY);
   }
+  DICTIONARY = NULL;
 }
 
 
-int submit_word_tileset(struct Game *game, const char *word) {
-  int score = 0;
+int set_threads_tileset(const int num_threads) {
+  long n = num_threads;
+  if (n <= 0) {
+    n = sysconf(_SC_NPROCESSORS_ONLN);
+  }
 
-  /* try and find the word in the dictionary */
-  const int num_words = NUM_EN_GB;
-  for (int i = 0; i < num_words; ++i) {
-    if (!strcmp(word, EN_GB[i])) {
-      // word found
-      score = score_word_tileset(game, word);
-
-      // check if the word is better than the current best
-      if (score > game->score) {
-        game->score = score;
-        strcpy(game->word, word);
+  NUM_THREADS = n < 1 ? 1 : n > MAX_THREADS ? MAX_THREADS : (int) n;
+  return NUM_THREADS;
+}
+
+
+int set_solver_tileset(const Solver solver) {
+  switch (solver) {
+    case SOLVER_TRIE:
+      break;
+    case SOLVER_ANAGRAM:
+      if (load_anagrams()) {
+        return 2;
       }
       break;
-    }
-  }
-
-  /* if the word was found, see if it matches any of the top words */
-  if (score > 0) {
-    for (int i = 0; i < STORE; i++) {
-      if (!strncmp(game->top_words[i], word, SIZE)) {
-        game->has_found[i] = 1;
-        break;
+    case SOLVER_HISTOGRAM:
+      if (load_histograms()) {
+        return 2;
       }
-    }
+      break;
+    default:
+      return 1;
   }
 
-  return score;
+  SOLVER = solver;
+  return 0;
 }
 
 
-void top_words_tileset(struct Game *game) {
-  /* construct a prefix tree containing all of the words in the dictionary */
-  Trie root = trie_root();
-  for (int i = 0; i < NUM_EN_GB; i++) {
-    trie_insert(&root, EN_GB[i]);
+int set_histogram_backend_tileset(const HistogramBackend backend) {
+  if (!histogram_supports(backend)) {
+    return 1;
   }
 
-  /* do a depth first search of the trie to find the best words */
-  const char prefix[SIZE + 1] = {0};
-  const char used[SIZE + 1] = {0};
-  depth_first_search(&root, game, prefix, used, 0);
-
-  trie_free(&root);
-
-  /* sort the words from best to worst */
-  // use shell sort
-  int k = 0;
-  while (++k) {
-    const int gap = 2 * (STORE >> (k + 1)) + 1;
+  HISTOGRAM_BACKEND = backend;
+  return 0;
+}
 
-    for (int i = gap; i < STORE; i++) {
-      for (int j = i - gap; j >= 0; j -= gap) {
-        // determine if the current word is better than the next (by score then alphabetically)
-        int is_better = game->top_scores[j] < game->top_scores[j + gap];
-        if (game->top_scores[j] == game->top_scores[j + gap]) {
-          is_better = strcmp(game->top_words[j], game->top_words[j + gap]) > 0;
-        }
+
+/**
+ * Clear the game state, ready for a new rack.
+ *
+ * @param game the game state
+ */
+static void clear_game(struct Game *game) {
+  game->score = 0;
+  memset(game->top_scores, 0, STORE * sizeof(int));
+  memset(game->has_found, 0, STORE * sizeof(int));
+  memset(game->submitted_scores, 0, STORE * sizeof(int));
+  for (int i = 0; i < STORE; i++) {
+    memset(game->top_words[i], 0, SIZE + 1);
+    memset(game->submitted[i], 0, SIZE + 1);
+  }
+}
+
+
+/**
+ * Remember a valid word that was submitted, if it is one of the best submitted so far.
+ *
+ * Words are ranked the same way as the best words (by score, then alphabetically), so any submitted word that turns out
+ * to be one of the best words is one of the best STORE submitted words. This lets the best words be marked as found
+ * once a background search finishes, however many words were submitted while it ran.
+ *
+ * @param game the game state
+ * @param word the word
+ * @param score the score of the word
+ */
+static void add_submitted_word(struct Game *game, const char *word, const int score) {
+  int i = 0;
+  for (; i < STORE && game->submitted[i][0] != '\0'; i++) {
+    const int cmp = strncmp(game->submitted[i], word, SIZE);
+    if (cmp == 0) {
+      return; // already submitted (the same word always has the same score, so is found before any worse word)
+    }
+    if (score > game->submitted_scores[i] || (score == game->submitted_scores[i] && cmp > 0)) {
+      break;
+    }
+  }
+  if (i == STORE) {
+    return;
+  }
+
+  /* make room, dropping the worst word if the list is full */
+  for (int j = STORE - 1; j > i; j--) {
+    memcpy(game->submitted[j], game->submitted[j - 1], SIZE + 1);
+    game->submitted_scores[j] = game->submitted_scores[j - 1];
+  }
+  strncpy(game->submitted[i], word, SIZE);
+  game->submitted[i][SIZE] = '\0';
+  game->submitted_scores[i] = score;
+}
+
+
+/**
+ * Pick random indices into the LETTERS array, not allowing replacement.
+ *
+ * @param indices the indices to set
+ * @param rng state of the xorshift generator to draw from (NULL to use rand)
+ */
+static void draw_indices(char indices[SIZE], uint64_t *rng) {
+  for (int i = 0; i < SIZE; i++) {
+    int redraw;
+    do {
+      // get a random index
+      if (rng) {
+        *rng ^= *rng << 13;
+        *rng ^= *rng >> 7;
+        *rng ^= *rng << 17;
+        indices[i] = (char) ((*rng >> 32) % 100);
+      } else {
+        indices[i] = (char) (rand() % 100);
+      }
+
+      // check if the letter is already in the shuffle
+      redraw = 0;
+      for (int j = 0; j < i; j++) {
+        if (indices[i] == indices[j]) {
+          redraw = 1;
+          break;
+        }
+      }
+    } while (redraw);
+  }
+}
+
+
+/**
+ * Convert indices into the LETTERS array into letters.
+ *
+ * @param letters the indices to convert, which are replaced by the letters (and null-terminated)
+ */
+static void indices_to_letters(char letters[SIZE + 1]) {
+  for (int i = 0; i < SIZE; i++) {
+    letters[i] = LETTERS[(unsigned char) letters[i]];
+  }
+  letters[SIZE] = '\0'; // ensure the string is null-terminated
+}
+
+
+int reset_tileset(struct Game *game, const char *seed, const int get_top_words) {
+  clear_game(game);
+
+  if (seed) {
+    /* set indices into the letters array from the seed */
+    if (parse_seed(game->letters, seed)) {
+      return 1;
+    }
+  } else {
+    draw_indices(game->letters, NULL);
+  }
+  indices_to_letters(game->letters);
+
+  if (get_top_words) {
+    top_words_tileset(game);
+  }
+
+  return 0;
+}
+
+
+void shuffle_tileset(struct Game *game) {
+  // Perform a Fisher-Yates shuffle
+  for (int i = 0; i < SIZE - 1; i++) {
+    const int j = i + rand() / (RAND_MAX / (SIZE - i) + 1);
+    const char tmp = game->letters[j];
+    game->letters[j] = game->letters[i];
+    game->letters[i] = tmp;
+  }
+}
+
+
+int is_rack_word_tileset(const char *word) {
+  /* the dictionary only holds lowercase words, and only those that fit in a rack can be made */
+  int len = 0;
+  for (; word[len] != '\0'; len++) {
+    if (word[len] < 'a' || word[len] > 'z' || len == SIZE) {
+      return 0;
+    }
+  }
+
+  if (len == 0 || load_dictionary_tileset()) {
+    return 0;
+  }
+
+  return dict_contains(DICTIONARY, word, 0);
+}
+
+
+int submit_word_tileset(struct Game *game, const char *word) {
+  int score = 0;
+
+  /* try and find the word in the dictionary */
+  if (is_rack_word_tileset(word)) {
+    // word found
+    score = score_word_tileset(game, word);
+
+    // check if the word is better than the current best
+    if (score > game->score) {
+      game->score = score;
+      strcpy(game->word, word);
+    }
+  }
+
+  /* if the word was found, see if it matches any of the top words (which may still be being searched for) */
+  if (score > 0) {
+    add_submitted_word(game, word, score);
+    for (int i = 0; i < STORE; i++) {
+      if (!strncmp(game->top_words[i], word, SIZE)) {
+        game->has_found[i] = 1;
+        break;
+      }
+    }
+  }
+
+  return score;
+}
+
+
+/**
+ * Get the key used to cache the best words in a rack.
+ *
+ * @param letters the letters of the rack
+ * @param key set to the letters in sorted order (null-terminated)
+ */
+static void rack_key(const char letters[SIZE], char key[SIZE + 1]) {
+  memcpy(key, letters, SIZE);
+  key[SIZE] = '\0';
+
+  // insertion sort, since there are only a few letters
+  for (int i = 1; i < SIZE; i++) {
+    const char letter = key[i];
+    int j = i;
+    for (; j > 0 && key[j - 1] > letter; j--) {
+      key[j] = key[j - 1];
+    }
+    key[j] = letter;
+  }
+}
+
+
+/**
+ * Hash the letters of a rack.
+ *
+ * @param key the sorted letters of the rack
+ * @return the hash
+ */
+static uint32_t rack_hash(const char key[SIZE + 1]) {
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < SIZE; i++) {
+    hash ^= (unsigned char) key[i];
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+
+/**
+ * Get the hash chain that a rack belongs to.
+ *
+ * @param key the sorted letters of the rack
+ * @return the index of the hash chain
+ */
+static int cache_bucket(const char key[SIZE + 1]) {
+  return (int) (rack_hash(key) % CACHE_BUCKETS);
+}
+
+
+/**
+ * Empty the cache (which must be locked).
+ */
+static void cache_empty(void) {
+  memset(CACHE.chain, -1, sizeof(CACHE.chain));
+  memset(CACHE.newer, -1, sizeof(CACHE.newer));
+  memset(CACHE.older, -1, sizeof(CACHE.older));
+  memset(CACHE.buckets, -1, sizeof(CACHE.buckets));
+  CACHE.newest = -1;
+  CACHE.oldest = -1;
+  CACHE.count = 0;
+  CACHE.is_ready = 1;
+}
+
+
+/**
+ * Remove a record from the list of records in order of use (the cache must be locked).
+ *
+ * @param r the index of the record
+ */
+static void cache_unlink(const int r) {
+  if (CACHE.newer[r] >= 0) {
+    CACHE.older[CACHE.newer[r]] = CACHE.older[r];
+  } else {
+    CACHE.newest = CACHE.older[r];
+  }
+
+  if (CACHE.older[r] >= 0) {
+    CACHE.newer[CACHE.older[r]] = CACHE.newer[r];
+  } else {
+    CACHE.oldest = CACHE.newer[r];
+  }
+}
+
+
+/**
+ * Mark a record as the most recently used (the cache must be locked).
+ *
+ * @param r the index of the record, which must not be in the list of records in order of use
+ */
+static void cache_link_newest(const int r) {
+  CACHE.newer[r] = -1;
+  CACHE.older[r] = CACHE.newest;
+  if (CACHE.newest >= 0) {
+    CACHE.newer[CACHE.newest] = r;
+  } else {
+    CACHE.oldest = r;
+  }
+  CACHE.newest = r;
+}
+
+
+/**
+ * Find a rack in the cache (which must be locked).
+ *
+ * @param key the sorted letters of the rack
+ * @return the index of the record, or -1 if the rack is not in the cache
+ */
+static int cache_find(const char key[SIZE + 1]) {
+  if (!CACHE.is_ready) {
+    return -1;
+  }
+
+  for (int r = CACHE.buckets[cache_bucket(key)]; r >= 0; r = CACHE.chain[r]) {
+    if (!memcmp(CACHE.records[r].rack, key, SIZE)) {
+      return r;
+    }
+  }
+
+  return -1;
+}
+
+
+/**
+ * Add a record to the cache (which must be locked), replacing the least recently used one if the cache is full.
+ *
+ * @param record the record to add
+ */
+static void cache_add(const struct CacheRecord *record) {
+  if (!CACHE.is_ready) {
+    cache_empty();
+  }
+
+  /* update the rack if it is already cached */
+  int r = cache_find(record->rack);
+  if (r >= 0) {
+    CACHE.records[r] = *record;
+    cache_unlink(r);
+    cache_link_newest(r);
+    return;
+  }
+
+  if (CACHE.count < CACHE_SIZE) {
+    r = CACHE.count++;
+  } else {
+    /* evict the least recently used record, taking it out of its hash chain */
+    r = CACHE.oldest;
+    cache_unlink(r);
+
+    int *link = &CACHE.buckets[cache_bucket(CACHE.records[r].rack)];
+    while (*link != r) {
+      link = &CACHE.chain[*link];
+    }
+    *link = CACHE.chain[r];
+  }
+
+  CACHE.records[r] = *record;
+  const int bucket = cache_bucket(record->rack);
+  CACHE.chain[r] = CACHE.buckets[bucket];
+  CACHE.buckets[bucket] = r;
+  cache_link_newest(r);
+}
+
+
+/**
+ * Find the slot of a rack in the index of the cache file (which must be locked and have an index).
+ *
+ * @param key the sorted letters of the rack
+ * @return the slot holding the rack, or the empty slot it would go in
+ */
+static struct CacheSlot *cache_file_slot(const char key[SIZE + 1]) {
+  // linear probing, which always ends since the table is never more than half full
+  uint32_t i = rack_hash(key) & (CACHE.num_slots - 1);
+  while (CACHE.slots[i].rack[0] != '\0' && memcmp(CACHE.slots[i].rack, key, SIZE) != 0) {
+    i = (i + 1) & (CACHE.num_slots - 1);
+  }
+
+  return &CACHE.slots[i];
+}
+
+
+/**
+ * Make room in the index of the cache file (which must be locked) for another rack, creating the index if needed.
+ *
+ * @return 0 on success, 1 if out of memory
+ */
+static int cache_file_reserve(void) {
+  if (2 * (CACHE.num_records + 1) <= CACHE.num_slots) {
+    return 0;
+  }
+
+  /* move every rack into a table twice the size */
+  const uint32_t old_num_slots = CACHE.num_slots;
+  struct CacheSlot *old_slots = CACHE.slots;
+  const uint32_t num_slots = old_num_slots ? 2 * old_num_slots : 2 * CACHE_SIZE;
+  struct CacheSlot *slots = calloc(num_slots, sizeof(struct CacheSlot));
+  if (!slots) {
+    return 1;
+  }
+
+  CACHE.slots = slots;
+  CACHE.num_slots = num_slots;
+  for (uint32_t i = 0; i < old_num_slots; i++) {
+    if (old_slots[i].rack[0] != '\0') {
+      *cache_file_slot(old_slots[i].rack) = old_slots[i];
+    }
+  }
+  free(old_slots);
+
+  return 0;
+}
+
+
+/**
+ * Add a rack to the index of the cache file (which must be locked), growing the index if it is getting full.
+ *
+ * @param key the sorted letters of the rack
+ * @param record the index of the rack's record in the file
+ * @return 0 on success, 1 if out of memory
+ */
+static int cache_file_index(const char key[SIZE + 1], const uint32_t record) {
+  if (cache_file_reserve()) {
+    return 1;
+  }
+
+  // a rack written more than once (by an older version) keeps its latest record
+  struct CacheSlot *slot = cache_file_slot(key);
+  memcpy(slot->rack, key, SIZE);
+  slot->rack[SIZE] = '\0';
+  slot->record = record;
+  return 0;
+}
+
+
+/**
+ * Close the cache file and free its index (the cache must be locked).
+ */
+static void cache_file_close(void) {
+  if (CACHE.fp) {
+    fclose(CACHE.fp);
+    CACHE.fp = NULL;
+  }
+
+  free(CACHE.slots);
+  CACHE.slots = NULL;
+  CACHE.num_slots = 0;
+  CACHE.num_records = 0;
+}
+
+
+/**
+ * Read a rack's record back from the cache file (which must be locked), if the rack is in the file.
+ *
+ * @param key the sorted letters of the rack
+ * @param record set to the record of the rack
+ * @return 1 if the rack was read, 0 otherwise
+ */
+static int cache_file_read(const char key[SIZE + 1], struct CacheRecord *record) {
+  if (!CACHE.fp || !CACHE.slots) {
+    return 0;
+  }
+
+  const struct CacheSlot *slot = cache_file_slot(key);
+  if (slot->rack[0] == '\0') {
+    return 0;
+  }
+
+  const long offset = (long) sizeof(struct CacheHeader) + (long) slot->record * (long) sizeof(struct CacheRecord);
+  if (fseek(CACHE.fp, offset, SEEK_SET) || fread(record, sizeof(struct CacheRecord), 1, CACHE.fp) != 1) {
+    return 0;
+  }
+  record->rack[SIZE] = '\0';
+
+  return !memcmp(record->rack, key, SIZE);
+}
+
+
+/**
+ * Look up the best words for a rack in the cache.
+ *
+ * @param key the sorted letters of the rack
+ * @param game the game state, which receives the best words if the rack is found
+ * @return 1 if the rack was found, 0 otherwise
+ */
+static int cache_get(const char key[SIZE + 1], struct Game *game) {
+  pthread_mutex_lock(&CACHE.lock);
+
+  /* fall back to the file for racks that have dropped out of memory */
+  int r = cache_find(key);
+  if (r >= 0) {
+    cache_unlink(r);
+    cache_link_newest(r);
+  } else {
+    struct CacheRecord record;
+    if (cache_file_read(key, &record)) {
+      cache_add(&record);
+      r = CACHE.newest;
+    }
+  }
+
+  if (r >= 0) {
+    memcpy(game->top_words, CACHE.records[r].top_words, sizeof(game->top_words));
+    memcpy(game->top_scores, CACHE.records[r].top_scores, sizeof(game->top_scores));
+    CACHE.hits++;
+  } else {
+    CACHE.misses++;
+  }
+
+  pthread_mutex_unlock(&CACHE.lock);
+  return r >= 0;
+}
+
+
+/**
+ * Store the best words for a rack in the cache, and in the cache file if one is open.
+ *
+ * @param key the sorted letters of the rack
+ * @param game the game state, holding the best words (from best to worst)
+ */
+static void cache_put(const char key[SIZE + 1], const struct Game *game) {
+  struct CacheRecord record;
+  memset(&record, 0, sizeof(record));
+  memcpy(record.rack, key, sizeof(record.rack));
+  memcpy(record.top_words, game->top_words, sizeof(record.top_words));
+  memcpy(record.top_scores, game->top_scores, sizeof(record.top_scores));
+
+  pthread_mutex_lock(&CACHE.lock);
+
+  cache_add(&record);
+
+  /* append the rack to the file, unless it is already there (such as when two threads solve it at once) */
+  if (CACHE.fp && CACHE.slots && cache_file_slot(key)->rack[0] == '\0') {
+    // the seek is needed between reading and writing, even though writes always go to the end
+    if (fseek(CACHE.fp, 0, SEEK_END) || fwrite(&record, sizeof(record), 1, CACHE.fp) != 1 || fflush(CACHE.fp) ||
+        cache_file_index(key, CACHE.num_records)) {
+      // stop using a file that can't be written to, rather than leaving a partial record in it
+      cache_file_close();
+    } else {
+      CACHE.num_records++;
+    }
+  }
+
+  pthread_mutex_unlock(&CACHE.lock);
+}
+
+
+/**
+ * Find the best words in a rack, storing them (sorted from best to worst) in the game state.
+ *
+ * Racks with the same letters have the same best words, so unless told otherwise the rack is looked up in the table
+ * of every rack's best words, then in the cache of recently solved racks, before searching the dictionary.
+ *
+ * @param game the game state
+ * @param cancel flag set by another thread to stop the search early (NULL if it cannot be cancelled)
+ * @param use_lookups whether to use the table and cache (1) or always search the dictionary (0)
+ */
+static void find_top_words(struct Game *game, const int *cancel, const int use_lookups) {
+  if (load_dictionary_tileset()) {
+    return;
+  }
+
+  /* count up the tiles */
+  struct Search search;
+  memset(&search, 0, sizeof(search));
+  search.dict = DICTIONARY;
+  search.game = game;
+  search.cancel = cancel;
+  for (int i = 0; i < SIZE; i++) {
+    search.counts[game->letters[i] == BLANK ? 26 : game->letters[i] - 'a']++;
+  }
+
+  static_assert(TABLE_SYMBOLS == sizeof(search.counts) / sizeof(int), "tiles must be counted the same as the table");
+  if (use_lookups && TABLE.map && table_lookup(&TABLE, search.counts, game->top_words, game->top_scores)) {
+    return;
+  }
+
+  char key[SIZE + 1];
+  rack_key(game->letters, key);
+  if (use_lookups && cache_get(key, game)) {
+    return;
+  }
+
+  /* look up the best words by their letters, or do a depth first search of the trie to find them */
+  if (SOLVER == SOLVER_ANAGRAM && !load_anagrams()) {
+    int word_counts[26] = {0};
+    search_anagrams(&search, &ANAGRAMS, word_counts, 0, 0, 0);
+  } else if (SOLVER == SOLVER_HISTOGRAM && !load_histograms()) {
+    search_histograms(&search, &HISTOGRAMS);
+  } else if (NUM_THREADS > 1) {
+    solve_parallel(&search, NUM_THREADS);
+  } else {
+    for (int k = 0; k < 26 && !is_cancelled(&search); k++) {
+      search_letter(&search, 0, 0, 0, k);
+    }
+  }
+
+  /* sort the words from best to worst */
+  // use shell sort
+  int k = 0;
+  while (++k) {
+    const int gap = 2 * (STORE >> (k + 1)) + 1;
+
+    for (int i = gap; i < STORE; i++) {
+      for (int j = i - gap; j >= 0; j -= gap) {
+        // determine if the current word is better than the next (by score then alphabetically)
+        int is_better = game->top_scores[j] < game->top_scores[j + gap];
+        if (game->top_scores[j] == game->top_scores[j + gap]) {
+          is_better = strcmp(game->top_words[j], game->top_words[j + gap]) > 0;
+        }
 
         if (is_better) {
           // swap the scores
@@ -392,6 +1337,289 @@ void top_words_tileset(struct Game *game) {
       break;
     }
   }
+
+  /* remember the best words, unless the search was stopped part way through */
+  if (use_lookups && !is_cancelled(&search)) {
+    cache_put(key, game);
+  }
+}
+
+
+void top_words_tileset(struct Game *game) {
+  find_top_words(game, NULL, 1);
+}
+
+
+void search_top_words_tileset(struct Game *game) {
+  find_top_words(game, NULL, 0);
+}
+
+
+int open_table_tileset(const char *path) {
+  free_table_tileset();
+  if (load_dictionary_tileset()) {
+    return 1;
+  }
+
+  return table_open(&TABLE, path, dict_checksum(DICTIONARY));
+}
+
+
+void free_table_tileset(void) {
+  table_free(&TABLE);
+}
+
+
+const Dict *dictionary_tileset(void) {
+  if (load_dictionary_tileset()) {
+    return NULL;
+  }
+
+  return DICTIONARY;
+}
+
+
+int open_cache_tileset(const char *path) {
+  if (load_dictionary_tileset()) {
+    return 1;
+  }
+
+  struct CacheHeader expected;
+  memset(&expected, 0, sizeof(expected));
+  memcpy(expected.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  expected.version = CACHE_VERSION;
+  expected.size = SIZE;
+  expected.store = STORE;
+  expected.dict_checksum = dict_checksum(DICTIONARY);
+
+  /* open the file for appending, creating it if it doesn't exist */
+  FILE *fp = fopen(path, "a+b");
+  if (!fp) {
+    return 1;
+  }
+  rewind(fp);
+
+  pthread_mutex_lock(&CACHE.lock);
+  cache_file_close();
+
+  /* index the records, as long as they were found with the same rules and dictionary (the most recent are also kept
+   * in memory) */
+  struct CacheHeader header;
+  long end = 0;
+  int err = 0;
+  if (fread(&header, sizeof(header), 1, fp) == 1 && !memcmp(&header, &expected, sizeof(header))) {
+    end = (long) sizeof(header);
+
+    struct CacheRecord record;
+    while (!err && fread(&record, sizeof(record), 1, fp) == 1) {
+      record.rack[SIZE] = '\0';
+      cache_add(&record);
+      err = cache_file_index(record.rack, CACHE.num_records);
+      CACHE.num_records++;
+      end += (long) sizeof(record);
+    }
+  }
+  err = err || cache_file_reserve(); // an empty file still needs an index to add racks to
+
+  /* drop anything after the last whole record (or everything, if the file is out of date) */
+  err = err || fflush(fp) || ftruncate(fileno(fp), end);
+  if (!err && end == 0) {
+    err = fwrite(&expected, sizeof(expected), 1, fp) != 1 || fflush(fp);
+  }
+
+  if (err) {
+    fclose(fp);
+    cache_file_close();
+  } else {
+    CACHE.fp = fp;
+  }
+
+  pthread_mutex_unlock(&CACHE.lock);
+  return err;
+}
+
+
+void clear_cache_tileset(void) {
+  pthread_mutex_lock(&CACHE.lock);
+
+  cache_file_close();
+  cache_empty();
+  CACHE.hits = 0;
+  CACHE.misses = 0;
+
+  pthread_mutex_unlock(&CACHE.lock);
+}
+
+
+void stats_cache_tileset(int *hits, int *misses) {
+  pthread_mutex_lock(&CACHE.lock);
+  *hits = CACHE.hits;
+  *misses = CACHE.misses;
+  pthread_mutex_unlock(&CACHE.lock);
+}
+
+
+/**
+ * Run a background search.
+ *
+ * @param arg pointer to the task
+ * @return NULL
+ */
+static void *solve_task(void *arg) {
+  struct SolveTask *task = arg;
+
+  find_top_words(&task->game, &task->cancel, 1);
+  __atomic_store_n(&task->done, 1, __ATOMIC_RELEASE);
+
+  return NULL;
+}
+
+
+struct SolveTask *start_solve_tileset(const struct Game *game) {
+  /* load the dictionary on this thread, so that the background thread only reads it */
+  if (load_dictionary_tileset()) {
+    return NULL;
+  }
+
+  struct SolveTask *task = calloc(1, sizeof(struct SolveTask));
+  if (!task) {
+    return NULL;
+  }
+  memcpy(task->game.letters, game->letters, sizeof(task->game.letters));
+
+  if (pthread_create(&task->thread, NULL, solve_task, task)) {
+    free(task);
+    return NULL;
+  }
+
+  return task;
+}
+
+
+int poll_solve_tileset(const struct SolveTask *task) {
+  return __atomic_load_n(&task->done, __ATOMIC_ACQUIRE);
+}
+
+
+void join_solve_tileset(struct SolveTask *task, struct Game *game) {
+  pthread_join(task->thread, NULL);
+
+  /* copy over the best words, keeping track of any that have already been found */
+  memcpy(game->top_words, task->game.top_words, sizeof(game->top_words));
+  memcpy(game->top_scores, task->game.top_scores, sizeof(game->top_scores));
+  for (int i = 0; i < STORE; i++) {
+    for (int j = 0; j < STORE && game->submitted[j][0] != '\0'; j++) {
+      if (!strncmp(game->top_words[i], game->submitted[j], SIZE)) {
+        game->has_found[i] = 1;
+        break;
+      }
+    }
+  }
+
+  free(task);
+}
+
+
+void cancel_solve_tileset(struct SolveTask *task) {
+  __atomic_store_n(&task->cancel, 1, __ATOMIC_RELAXED);
+  pthread_join(task->thread, NULL);
+
+  free(task);
+}
+
+
+/**
+ * Start finding the best words in a prefetcher's next rack.
+ *
+ * @param prefetch the prefetcher
+ */
+static void solve_prefetched_rack(struct Prefetch *prefetch) {
+  struct Game next;
+  clear_game(&next);
+  memcpy(next.letters, prefetch->letters, sizeof(next.letters));
+
+  prefetch->task = start_solve_tileset(&next);
+  prefetch->is_waiting = 0;
+}
+
+
+/**
+ * Draw the next rack for a prefetcher, and start finding its best words unless told to wait.
+ *
+ * @param prefetch the prefetcher
+ * @param is_waiting whether to wait for resume_prefetch_tileset before starting the search
+ */
+static void prefetch_rack(struct Prefetch *prefetch, const int is_waiting) {
+  draw_indices(prefetch->letters, &prefetch->rng);
+  indices_to_letters(prefetch->letters);
+
+  prefetch->task = NULL;
+  prefetch->is_waiting = is_waiting;
+  if (!is_waiting) {
+    solve_prefetched_rack(prefetch);
+  }
+}
+
+
+struct Prefetch *start_prefetch_tileset(const unsigned int seed) {
+  struct Prefetch *prefetch = calloc(1, sizeof(struct Prefetch));
+  if (!prefetch) {
+    return NULL;
+  }
+
+  // xorshift gets stuck on 0, so mix the seed into a non-zero constant
+  prefetch->rng = 0x9E3779B97F4A7C15ull ^ seed;
+  prefetch_rack(prefetch, 0);
+
+  return prefetch;
+}
+
+
+struct SolveTask *next_rack_tileset(struct Prefetch *prefetch, struct Game *game) {
+  clear_game(game);
+  memcpy(game->letters, prefetch->letters, sizeof(game->letters));
+
+  /* the search for this rack may still be waiting, if the last one handed over was never resumed from */
+  resume_prefetch_tileset(prefetch);
+
+  /* swap in the best words if they have already been found */
+  struct SolveTask *task = prefetch->task;
+  if (task && poll_solve_tileset(task)) {
+    join_solve_tileset(task, game);
+    task = NULL;
+    prefetch->hits++;
+  } else {
+    prefetch->misses++;
+    if (!task) {
+      top_words_tileset(game); // the search could not be started in the background
+    }
+  }
+
+  // a search handed over is still using the threads, so the next one waits for it to be joined or cancelled
+  prefetch_rack(prefetch, task != NULL);
+  return task;
+}
+
+
+void resume_prefetch_tileset(struct Prefetch *prefetch) {
+  if (prefetch->is_waiting) {
+    solve_prefetched_rack(prefetch);
+  }
+}
+
+
+void stats_prefetch_tileset(const struct Prefetch *prefetch, int *hits, int *misses) {
+  *hits = prefetch->hits;
+  *misses = prefetch->misses;
+}
+
+
+void free_prefetch_tileset(struct Prefetch *prefetch) {
+  if (prefetch->task) {
+    cancel_solve_tileset(prefetch->task);
+  }
+
+  free(prefetch);
 }
 
 
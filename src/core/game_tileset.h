@@ -5,10 +5,20 @@
 #ifndef GAME_TILESET_H
 #define GAME_TILESET_H
 
+#include "src/core/dict.h"
+#include "src/core/histogram.h"
+
 #define SIZE (7) // the number of letters available
 #define STORE (10) // the number of top words to store
 #define BLANK (' ') // the blank tile
 
+// Scores for each letter (the blank scores 0)
+#define LETTER_SCORES {1, 3, 3, 2, 1, 4, 2, 4, 1, 8, 5, 1, 3, 1, 1, 3, 10, 1, 1, 1, 1, 4, 4, 8, 4, 10,}
+//                     a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p,  q, r, s, t, u, v, w, x, y,  z
+#define MAX_LETTER_SCORE (10) // the highest score in LETTER_SCORES
+#define CACHE_SIZE (1024) // the number of racks whose best words are kept in memory
+#define MAX_THREADS (26) // the most threads used to find the best words (one for each first letter)
+
 
 /**
  * Game state.
@@ -22,9 +32,153 @@ struct Game {
   char top_words[STORE][SIZE + 1]; // best available words (always null-terminated)
   int top_scores[STORE]; // scores of the best available words
   int has_found[STORE]; // 0 = not found, 1 = found
+
+  char submitted[STORE][SIZE + 1]; // best valid words submitted so far, from best to worst (empty if none)
+  int submitted_scores[STORE]; // scores of the best submitted words
 };
 
 
+/**
+ * Ways of finding the best words in a rack.
+ */
+typedef enum Solver {
+  SOLVER_TRIE, // depth first search of the dictionary's prefix tree
+  SOLVER_ANAGRAM, // look up every set of letters in the rack in an index of words by their letters
+  SOLVER_HISTOGRAM, // check the letter counts of every word against the rack
+} Solver;
+
+
+/**
+ * Search for the best words running in the background (see start_solve_tileset).
+ */
+struct SolveTask;
+
+
+/**
+ * Source of upcoming racks, each drawn and solved ahead of time (see start_prefetch_tileset).
+ */
+struct Prefetch;
+
+
+/**
+ * Load the dictionary used to solve and validate every game.
+ *
+ * This is done automatically on first use, but can be called up front to avoid a delay in the first game. Calling it
+ * again once the dictionary is loaded does nothing.
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+int load_dictionary_tileset(void);
+
+
+/**
+ * Use a dictionary file (see dict_open) instead of the built-in dictionary.
+ *
+ * Any previously loaded dictionary is released first.
+ *
+ * @param path The dictionary file to open.
+ * @return 0 on success, non-zero on failure (in which case no dictionary is loaded).
+ */
+int open_dictionary_tileset(const char *path);
+
+
+/**
+ * Release the dictionary used to solve and validate every game.
+ *
+ * It will be reloaded if it is needed again.
+ */
+void free_dictionary_tileset(void);
+
+
+/**
+ * Use a table of the best words for every possible rack (see src/tools/mktable.c), instead of searching for them.
+ *
+ * The table is mapped from the file, so only the racks that are used are ever read. Any racks missing from the table
+ * are still searched for. The table is closed when the dictionary is freed, so open the dictionary first.
+ *
+ * @param path The table file to open.
+ * @return 0 on success, 1 if the file could not be read, 2 if it was made for a different dictionary or build, 3 if
+ *         it is corrupt.
+ */
+int open_table_tileset(const char *path);
+
+
+/**
+ * Stop using the table of the best words for every possible rack.
+ */
+void free_table_tileset(void);
+
+
+/**
+ * Get the dictionary used to solve and validate every game, loading it if necessary.
+ *
+ * @return The dictionary, or NULL if it could not be loaded.
+ */
+const Dict *dictionary_tileset(void);
+
+
+/**
+ * Keep the best words for each rack in a file, as well as in memory.
+ *
+ * Racks with the same letters (in any order) have the same best words, so once a rack is in the file it is never
+ * searched again. The most recently used racks are kept in memory, and every rack in the file is indexed when the file
+ * is opened, so racks that have dropped out of memory are read back from the file. Each new rack is appended to the
+ * file once. A file written with a different dictionary is emptied. The cache is closed (and emptied) when the
+ * dictionary is freed, so open the dictionary first.
+ *
+ * @param path The cache file to use (created if it doesn't exist).
+ * @return 0 on success, non-zero on failure (in which case only the in-memory cache is used).
+ */
+int open_cache_tileset(const char *path);
+
+
+/**
+ * Empty the cache of best words for each rack, closing the cache file if one is open.
+ */
+void clear_cache_tileset(void);
+
+
+/**
+ * Get the number of racks whose best words were (and were not) found in the cache.
+ *
+ * @param hits Set to the number of racks found in the cache.
+ * @param misses Set to the number of racks that had to be searched.
+ */
+void stats_cache_tileset(int *hits, int *misses);
+
+
+/**
+ * Set the number of threads used to find the best words in each rack.
+ *
+ * The first letters of the words are shared out between the threads. Spawning the threads has a small cost, so this
+ * only helps for slow racks (such as those with two blanks). By default only the calling thread is used.
+ *
+ * @param num_threads The number of threads (0 for one per CPU core), clamped between 1 and MAX_THREADS.
+ * @return The number of threads that will be used.
+ */
+int set_threads_tileset(int num_threads);
+
+
+/**
+ * Set how the best words in each rack are found.
+ *
+ * Both solvers find the same words, so this only changes how long each rack takes.
+ *
+ * @param solver The solver to use (SOLVER_TRIE by default).
+ * @return 0 on success, 1 for an unknown solver, 2 if the solver could not be set up (in which case it is unchanged).
+ */
+int set_solver_tileset(Solver solver);
+
+
+/**
+ * Set how the histogram solver scans the letter counts of every word.
+ *
+ * @param backend The backend to use (HISTOGRAM_AUTO by default, which picks the fastest the CPU supports).
+ * @return 0 on success, non-zero if the CPU does not support the backend (in which case it is unchanged).
+ */
+int set_histogram_backend_tileset(HistogramBackend backend);
+
+
 /**
  * Reset the game state, choosing a random set of letters.
  *
@@ -46,6 +200,21 @@ int reset_tileset(struct Game *game, const char *seed, int get_top_words);
 void shuffle_tileset(struct Game *game);
 
 
+/**
+ * Check if a word is in the dictionary and short enough to be made from a rack (at most SIZE letters).
+ *
+ * Longer words are always rejected, as they can never be submitted (and the built-in dictionary leaves them out), so
+ * this is not a general dictionary check. It does not depend on the letters of any particular rack.
+ *
+ * This walks the flattened prefix tree one letter at a time, so it takes the same time however big the dictionary is
+ * and can be used to check many submitted words at once (such as replaying a game's log).
+ *
+ * @param word The word to check.
+ * @return 1 if the word is in the dictionary and fits in a rack, 0 otherwise.
+ */
+int is_rack_word_tileset(const char *word);
+
+
 /**
  * Submit a word to the game state.
  *
@@ -87,6 +256,110 @@ int score_word_tileset(const struct Game *game, const char *word);
 void top_words_tileset(struct Game *game);
 
 
+/**
+ * Search the dictionary for the best words, without using the table or cache of best words (or adding to the cache).
+ *
+ * @param game The game state.
+ */
+void search_top_words_tileset(struct Game *game);
+
+
+/**
+ * Start finding the best words on a background thread, so that the game can be shown straight away.
+ *
+ * The letters are copied, so the game can still be played (and shuffled) while the search runs. The dictionary must
+ * not be changed or freed until the search is joined or cancelled.
+ *
+ * @param game The game state.
+ * @return The search (finish with join_solve_tileset or cancel_solve_tileset), or NULL on failure.
+ */
+struct SolveTask *start_solve_tileset(const struct Game *game);
+
+
+/**
+ * Check if a background search has finished, without waiting for it.
+ *
+ * @param task The search.
+ * @return 1 if the search has finished, 0 otherwise.
+ */
+int poll_solve_tileset(const struct SolveTask *task);
+
+
+/**
+ * Wait for a background search to finish, then store the best words in the game state.
+ *
+ * Every word submitted while the search was running is marked as found if it is one of the best words. The search is
+ * freed.
+ *
+ * @param task The search.
+ * @param game The game state that the search was started for.
+ */
+void join_solve_tileset(struct SolveTask *task, struct Game *game);
+
+
+/**
+ * Stop a background search early, discarding its results. The search is freed.
+ *
+ * @param task The search.
+ */
+void cancel_solve_tileset(struct SolveTask *task);
+
+
+/**
+ * Start drawing racks ahead of time, finding the best words for each one in the background.
+ *
+ * The racks come from the prefetcher's own random number generator, so the same seed always gives the same racks
+ * (independent of rand and any other prefetchers).
+ *
+ * @param seed The seed for the random number generator.
+ * @return The prefetcher (free with free_prefetch_tileset), or NULL on failure.
+ */
+struct Prefetch *start_prefetch_tileset(unsigned int seed);
+
+
+/**
+ * Reset the game state with the next prefetched rack, then start preparing the one after.
+ *
+ * If the best words have already been found they are swapped straight in (a hit). Otherwise (a miss) the search that
+ * is still running is handed over, to be finished with join_solve_tileset. So that the two searches do not compete for
+ * the same threads, the search for the rack after is then held back until resume_prefetch_tileset is called, which
+ * should be once the handed over search has been joined or cancelled.
+ *
+ * @param prefetch The prefetcher.
+ * @param game The game state.
+ * @return NULL if the game has its best words, otherwise the search that will find them.
+ */
+struct SolveTask *next_rack_tileset(struct Prefetch *prefetch, struct Game *game);
+
+
+/**
+ * Start the search for the next prefetched rack, if it was held back by a miss (see next_rack_tileset).
+ *
+ * Does nothing if the search has already been started.
+ *
+ * @param prefetch The prefetcher.
+ */
+void resume_prefetch_tileset(struct Prefetch *prefetch);
+
+
+/**
+ * Get the number of prefetched racks that were (and were not) already solved when they were needed.
+ *
+ * @param prefetch The prefetcher.
+ * @param hits Set to the number of racks that were already solved.
+ * @param misses Set to the number of racks that were still being solved.
+ */
+void stats_prefetch_tileset(const struct Prefetch *prefetch, int *hits, int *misses);
+
+
+/**
+ * Stop prefetching racks.
+ *
+ * @param prefetch The prefetcher.
+ */
+void free_prefetch_tileset(struct Prefetch *prefetch);
+
+
 /**
  * Find the blanks in a word.
  *
@@ -0,0 +1,205 @@
+#include "histogram.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HISTOGRAM_X86 (1)
+#include <immintrin.h>
+#else
+#define HISTOGRAM_X86 (0)
+#endif
+
+
+/**
+ * Get the number of letters a word needs beyond those in the rack, one letter at a time.
+ *
+ * @param record the letter counts of the word
+ * @param rack the letter counts of the rack
+ * @return the number of missing letters
+ */
+static int deficit_scalar(const uint8_t *record, const uint8_t *rack) {
+  int deficit = 0;
+  for (int k = 0; k < HISTOGRAM_WIDTH; k++) {
+    deficit += record[k] > rack[k] ? record[k] - rack[k] : 0;
+  }
+
+  return deficit;
+}
+
+
+/**
+ * Scan records one letter at a time.
+ *
+ * @param records the first record to check
+ * @param count the number of records to check
+ * @param rack the letter counts of the rack
+ * @param blanks the number of blanks in the rack
+ * @param base the index of the first record
+ * @param matches set to the index of each record that can be made
+ * @return the number of matches
+ */
+static uint32_t match_scalar(const uint8_t *records, const uint32_t count, const uint8_t *rack, const int blanks,
+                             const uint32_t base, uint32_t *matches) {
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    matches[n] = base + i;
+    n += deficit_scalar(records + (size_t) i * HISTOGRAM_WIDTH, rack) <= blanks;
+  }
+
+  return n;
+}
+
+
+#if HISTOGRAM_X86
+/**
+ * Scan records 16 letters at a time with SSE2.
+ *
+ * @param records the first record to check
+ * @param count the number of records to check
+ * @param rack the letter counts of the rack
+ * @param blanks the number of blanks in the rack
+ * @param base the index of the first record
+ * @param matches set to the index of each record that can be made
+ * @return the number of matches
+ */
+__attribute__((target("sse2")))
+static uint32_t match_sse2(const uint8_t *records, const uint32_t count, const uint8_t *rack, const int blanks,
+                           const uint32_t base, uint32_t *matches) {
+  const __m128i rack_lo = _mm_loadu_si128((const __m128i *) rack);
+  const __m128i rack_hi = _mm_loadu_si128((const __m128i *) (rack + 16));
+  const __m128i zero = _mm_setzero_si128();
+
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    const __m128i *record = (const __m128i *) (records + (size_t) i * HISTOGRAM_WIDTH);
+
+    // the saturating subtraction leaves how many of each letter are missing, which are summed in 8-byte groups
+    const __m128i lo = _mm_subs_epu8(_mm_load_si128(record), rack_lo);
+    const __m128i hi = _mm_subs_epu8(_mm_load_si128(record + 1), rack_hi);
+    const __m128i sums = _mm_add_epi64(_mm_sad_epu8(lo, zero), _mm_sad_epu8(hi, zero));
+    const int deficit = _mm_cvtsi128_si32(_mm_add_epi64(sums, _mm_unpackhi_epi64(sums, sums)));
+
+    matches[n] = base + i;
+    n += deficit <= blanks;
+  }
+
+  return n;
+}
+
+
+/**
+ * Scan records a whole record at a time with AVX2.
+ *
+ * @param records the first record to check
+ * @param count the number of records to check
+ * @param rack the letter counts of the rack
+ * @param blanks the number of blanks in the rack
+ * @param base the index of the first record
+ * @param matches set to the index of each record that can be made
+ * @return the number of matches
+ */
+__attribute__((target("avx2")))
+static uint32_t match_avx2(const uint8_t *records, const uint32_t count, const uint8_t *rack, const int blanks,
+                           const uint32_t base, uint32_t *matches) {
+  const __m256i rack_all = _mm256_loadu_si256((const __m256i *) rack);
+  const __m256i zero = _mm256_setzero_si256();
+
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    const __m256i *record = (const __m256i *) (records + (size_t) i * HISTOGRAM_WIDTH);
+
+    // as for SSE2, but with the four 8-byte sums in one register
+    const __m256i missing = _mm256_subs_epu8(_mm256_load_si256(record), rack_all);
+    const __m256i sums = _mm256_sad_epu8(missing, zero);
+    const __m128i halves = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+    const int deficit = _mm_cvtsi128_si32(_mm_add_epi64(halves, _mm_unpackhi_epi64(halves, halves)));
+
+    matches[n] = base + i;
+    n += deficit <= blanks;
+  }
+
+  return n;
+}
+#endif
+
+
+int histogram_supports(const HistogramBackend backend) {
+  switch (backend) {
+    case HISTOGRAM_AUTO:
+    case HISTOGRAM_SCALAR:
+      return 1;
+#if HISTOGRAM_X86
+    case HISTOGRAM_SSE2:
+      return __builtin_cpu_supports("sse2") != 0;
+    case HISTOGRAM_AVX2:
+      return __builtin_cpu_supports("avx2") != 0;
+#endif
+    default:
+      return 0;
+  }
+}
+
+
+int histogram_from_dict(Histogram *histogram, const Dict *dict, const int max_len) {
+  memset(histogram, 0, sizeof(Histogram));
+  if (max_len < 1 || max_len > UINT8_MAX) {
+    return 1;
+  }
+
+  uint32_t n;
+  if (dict_list_words(dict, max_len, &histogram->words, &n)) {
+    return 1;
+  }
+
+  /* count the letters of each word, leaving the padding at zero */
+  histogram->records = aligned_alloc(HISTOGRAM_WIDTH, (n ? n : 1) * (size_t) HISTOGRAM_WIDTH);
+  if (!histogram->records) {
+    histogram_free(histogram);
+    return 1;
+  }
+  memset(histogram->records, 0, (n ? n : 1) * (size_t) HISTOGRAM_WIDTH);
+
+  const size_t width = (size_t) max_len + 1;
+  for (uint32_t i = 0; i < n; i++) {
+    for (const char *ch = histogram->words + i * width; *ch; ch++) {
+      histogram->records[(size_t) i * HISTOGRAM_WIDTH + (size_t) (*ch - 'a')]++;
+    }
+  }
+  histogram->num_words = n;
+  histogram->max_len = max_len;
+
+  return 0;
+}
+
+
+void histogram_free(Histogram *histogram) {
+  free(histogram->records);
+  free(histogram->words);
+
+  memset(histogram, 0, sizeof(Histogram));
+}
+
+
+uint32_t histogram_match(const Histogram *histogram, HistogramBackend backend, const uint8_t rack[HISTOGRAM_WIDTH],
+                         const int blanks, const uint32_t first, const uint32_t last, uint32_t *matches) {
+  const uint8_t *records = histogram->records + (size_t) first * HISTOGRAM_WIDTH;
+  const uint32_t count = last - first;
+
+  /* pick the fastest backend if asked to */
+  if (backend == HISTOGRAM_AUTO) {
+    backend = histogram_supports(HISTOGRAM_AVX2) ? HISTOGRAM_AVX2 :
+              histogram_supports(HISTOGRAM_SSE2) ? HISTOGRAM_SSE2 : HISTOGRAM_SCALAR;
+  }
+
+  switch (backend) {
+#if HISTOGRAM_X86
+    case HISTOGRAM_SSE2:
+      return match_sse2(records, count, rack, blanks, first, matches);
+    case HISTOGRAM_AVX2:
+      return match_avx2(records, count, rack, blanks, first, matches);
+#endif
+    default:
+      return match_scalar(records, count, rack, blanks, first, matches);
+  }
+}
@@ -0,0 +1,83 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+
+#include "src/core/dict.h"
+
+
+#define HISTOGRAM_WIDTH (32) // bytes in each record (one count per letter, padded with zeros to a SIMD register)
+
+
+/**
+ * Ways of scanning the records of a histogram index.
+ */
+typedef enum HistogramBackend {
+  HISTOGRAM_AUTO, // the fastest backend the CPU supports
+  HISTOGRAM_SCALAR, // plain C, one letter at a time
+  HISTOGRAM_SSE2, // 16 letters at a time (x86 only)
+  HISTOGRAM_AVX2, // a whole record at a time (x86 only)
+} HistogramBackend;
+
+
+/**
+ * A read-only list of the words in a dictionary, each with a count of its letters.
+ *
+ * The letter counts are stored as one contiguous array of fixed-size records, so that checking which words can be
+ * made from a rack is a single branch-free pass over memory.
+ */
+typedef struct Histogram {
+  uint8_t *records; // HISTOGRAM_WIDTH letter counts for each word (aligned to HISTOGRAM_WIDTH bytes)
+  char *words; // the words (each taking max_len + 1 chars), in the same order as the records
+  uint32_t num_words; // number of words
+  int max_len; // longest word in the index
+} Histogram;
+
+
+/**
+ * Check if the CPU can use a backend.
+ *
+ * @param backend the backend
+ * @return 1 if the backend can be used, 0 otherwise
+ */
+int histogram_supports(HistogramBackend backend);
+
+
+/**
+ * Index the words in a dictionary up to a given length.
+ *
+ * @param histogram pointer to the index to set up (free with histogram_free)
+ * @param dict pointer to the dictionary
+ * @param max_len the longest words to index (at most UINT8_MAX)
+ * @return 0 on success, 1 on failure (due to failed malloc or too long a length)
+ */
+int histogram_from_dict(Histogram *histogram, const Dict *dict, int max_len);
+
+
+/**
+ * Free the memory used by a histogram index.
+ *
+ * @param histogram pointer to the index
+ */
+void histogram_free(Histogram *histogram);
+
+
+/**
+ * Find the words in part of the index that can be made from a rack.
+ *
+ * A word can be made if the number of letters it needs beyond those in the rack is no more than the number of blanks.
+ *
+ * @param histogram pointer to the index
+ * @param backend the backend to scan with (which must be supported, see histogram_supports)
+ * @param rack the number of each letter in the rack (padded with zeros to HISTOGRAM_WIDTH bytes)
+ * @param blanks the number of blanks in the rack
+ * @param first the first word to check
+ * @param last one past the last word to check (at most num_words)
+ * @param matches set to the index of each word that can be made (room for last - first of them)
+ * @return the number of words that can be made
+ */
+uint32_t histogram_match(const Histogram *histogram, HistogramBackend backend, const uint8_t rack[HISTOGRAM_WIDTH],
+                         int blanks, uint32_t first, uint32_t last, uint32_t *matches);
+
+
+#endif //HISTOGRAM_H
@@ -0,0 +1,244 @@
+#include "louds.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#define LOUDS_SELECT_RATE (256) // number of 0s between entries in the select index
+#define LOUDS_LABEL_BITS (5) // number of bits used to store each letter
+
+
+/**
+ * Count the nodes in a trie, expanding any shared nodes back into a tree.
+ *
+ * @param node pointer to the root of the (sub)trie
+ * @return the number of nodes, including this one
+ */
+static uint32_t count_nodes(const Trie *node) {
+  uint32_t count = 1;
+  for (int i = 0; i < 26; i++) {
+    if (node->children[i]) {
+      count += count_nodes(node->children[i]);
+    }
+  }
+
+  return count;
+}
+
+
+/**
+ * Get the number of 64-bit words needed to hold a number of bits.
+ *
+ * @param num_bits the number of bits
+ * @return the number of words
+ */
+static size_t num_words(const size_t num_bits) {
+  return (num_bits + 63) / 64;
+}
+
+
+/**
+ * Find the position of a 0 in the LOUDS bit vector.
+ *
+ * @param louds pointer to the LOUDS trie
+ * @param k which 0 to find (counting from 0)
+ * @return the position of the kth 0
+ */
+static size_t select0(const Louds *louds, const uint32_t k) {
+  /* start from the nearest indexed 0 at or before the one we want */
+  size_t pos = louds->select[k / LOUDS_SELECT_RATE];
+  uint32_t remaining = k % LOUDS_SELECT_RATE;
+  if (remaining == 0) {
+    return pos;
+  }
+
+  /* count 0s a word at a time until the word containing the kth 0 */
+  pos++;
+  size_t w = pos / 64;
+  uint64_t zeros = ~louds->bits[w] & (~(uint64_t) 0 << (pos % 64));
+  uint32_t count = (uint32_t) __builtin_popcountll(zeros);
+  while (count < remaining) {
+    remaining -= count;
+    zeros = ~louds->bits[++w];
+    count = (uint32_t) __builtin_popcountll(zeros);
+  }
+
+  /* then find it within the word */
+  for (uint32_t r = 1; r < remaining; r++) {
+    zeros &= zeros - 1;
+  }
+
+  return 64 * w + (size_t) __builtin_ctzll(zeros);
+}
+
+
+/**
+ * Get the letter index of a node.
+ *
+ * @param louds pointer to the LOUDS trie
+ * @param node the node number
+ * @return the index of the node's letter (0 for 'a')
+ */
+static uint32_t label(const Louds *louds, const uint32_t node) {
+  const size_t offset = (size_t) node * LOUDS_LABEL_BITS;
+  const size_t w = offset / 64;
+  const unsigned shift = offset % 64;
+
+  uint64_t value = louds->labels[w] >> shift;
+  if (shift > 64 - LOUDS_LABEL_BITS) {
+    value |= louds->labels[w + 1] << (64 - shift); // the label straddles two words
+  }
+
+  return (uint32_t) (value & ((1u << LOUDS_LABEL_BITS) - 1));
+}
+
+
+int louds_from_trie(Louds *louds, const Trie *root) {
+  const uint32_t n = count_nodes(root);
+  const size_t num_bits = 2 * (size_t) n - 1;
+
+  louds->num_nodes = n;
+  louds->bits = calloc(num_words(num_bits), sizeof(uint64_t));
+  louds->labels = calloc(num_words((size_t) n * LOUDS_LABEL_BITS) + 1, sizeof(uint64_t));
+  louds->terminal = calloc(num_words(n), sizeof(uint64_t));
+  louds->select = malloc((n / LOUDS_SELECT_RATE + 1) * sizeof(uint32_t));
+  const Trie **queue = malloc(n * sizeof(Trie *));
+  if (!louds->bits || !louds->labels || !louds->terminal || !louds->select || !queue) {
+    louds_free(louds);
+    free(queue);
+    return 1;
+  }
+
+  /* visit the nodes in breadth first order, writing out the degree of each one in unary */
+  size_t pos = 0;
+  uint32_t tail = 0;
+  queue[tail++] = root;
+  for (uint32_t k = 0; k < n; k++) {
+    const Trie *node = queue[k];
+
+    if (k > 0) {
+      const size_t offset = (size_t) k * LOUDS_LABEL_BITS;
+      const uint64_t letter = TRIE_IDX(node->letter);
+      louds->labels[offset / 64] |= letter << (offset % 64);
+      if (offset % 64 > 64 - LOUDS_LABEL_BITS) {
+        louds->labels[offset / 64 + 1] |= letter >> (64 - offset % 64);
+      }
+    }
+    if (node->is_terminal) {
+      louds->terminal[k / 64] |= (uint64_t) 1 << (k % 64);
+    }
+
+    for (int i = 0; i < 26; i++) {
+      if (node->children[i]) {
+        louds->bits[pos / 64] |= (uint64_t) 1 << (pos % 64);
+        pos++;
+        queue[tail++] = node->children[i];
+      }
+    }
+
+    /* the 0 that ends node k is the kth 0 */
+    if (k % LOUDS_SELECT_RATE == 0) {
+      louds->select[k / LOUDS_SELECT_RATE] = (uint32_t) pos;
+    }
+    pos++;
+  }
+  free(queue);
+
+  return 0;
+}
+
+
+void louds_free(Louds *louds) {
+  free(louds->bits);
+  free(louds->labels);
+  free(louds->terminal);
+  free(louds->select);
+
+  memset(louds, 0, sizeof(Louds));
+}
+
+
+size_t louds_size(const Louds *louds) {
+  const size_t n = louds->num_nodes;
+
+  return sizeof(uint64_t) * num_words(2 * n - 1)
+         + sizeof(uint64_t) * (num_words(n * LOUDS_LABEL_BITS) + 1)
+         + sizeof(uint64_t) * num_words(n)
+         + sizeof(uint32_t) * (n / LOUDS_SELECT_RATE + 1);
+}
+
+
+/**
+ * Find where the children of a node start in the LOUDS bit vector.
+ *
+ * @param louds pointer to the LOUDS trie
+ * @param node the node number
+ * @return the position of the first bit describing the node's children
+ */
+static size_t children_start(const Louds *louds, const uint32_t node) {
+  /* the children of node k follow the (k-1)th 0 */
+  return node == 0 ? 0 : select0(louds, node - 1) + 1;
+}
+
+
+uint32_t louds_step(const Louds *louds, const uint32_t node, const char ch) {
+  const size_t start = children_start(louds, node);
+
+  /* every 1 is the edge to a child, so there are (start - k) children of earlier nodes, plus the root */
+  const uint32_t first = (uint32_t) (start - node + 1);
+
+  /* the children run until the next 0 */
+  size_t w = start / 64;
+  uint64_t zeros = ~louds->bits[w] & (~(uint64_t) 0 << (start % 64));
+  while (!zeros) {
+    zeros = ~louds->bits[++w];
+  }
+  const uint32_t degree = (uint32_t) (64 * w + (size_t) __builtin_ctzll(zeros) - start);
+
+  /* children are in alphabetical order */
+  const uint32_t target = TRIE_IDX(ch);
+  for (uint32_t child = first; child < first + degree; child++) {
+    const uint32_t letter = label(louds, child);
+    if (letter == target) {
+      return child;
+    }
+    if (letter > target) {
+      break;
+    }
+  }
+
+  return LOUDS_NONE;
+}
+
+
+int louds_is_word(const Louds *louds, const uint32_t node) {
+  return (louds->terminal[node / 64] >> (node % 64)) & 1;
+}
+
+
+int louds_has_children(const Louds *louds, const uint32_t node) {
+  /* a node with children starts with a 1 */
+  const size_t start = children_start(louds, node);
+  return (louds->bits[start / 64] >> (start % 64)) & 1;
+}
+
+
+int louds_contains(const Louds *louds, const char *word, int prefix) {
+  uint32_t node = 0;
+
+  for (int i = 0; word[i] != '\0'; i++) {
+    const char ch = word[i];
+    if (ch < 'a' || ch > 'z') {
+      return 0;
+    }
+
+    /* only keep going if the correct child node exists */
+    node = louds_step(louds, node, ch);
+    if (node == LOUDS_NONE) {
+      return 0;
+    }
+  }
+
+  /* the word is in the trie, but is it a full word? */
+  return prefix || louds_is_word(louds, node);
+}
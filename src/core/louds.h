@@ -0,0 +1,99 @@
+#ifndef LOUDS_H
+#define LOUDS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "src/core/trie.h"
+
+
+#define LOUDS_NONE (UINT32_MAX) // node number returned when there is no such node
+
+
+/**
+ * A read-only succinct trie, stored as a level-order unary degree sequence (LOUDS).
+ *
+ * Nodes are numbered in breadth first order, with the root as node 0. The shape of the trie is a single bit vector
+ * holding, for each node in turn, a 1 for every child followed by a 0. Together with a 5-bit letter and a terminal bit
+ * for each node this takes around 8 bits per node, plus a small index used to find the start of each node's children.
+ */
+typedef struct Louds {
+  uint64_t *bits; // the LOUDS bit vector (2n - 1 bits for n nodes)
+  uint64_t *labels; // packed 5-bit letter index of each node
+  uint64_t *terminal; // bit set for each node that is the end of a word
+  uint32_t *select; // position of every LOUDS_SELECT_RATE-th 0 in the bit vector
+
+  uint32_t num_nodes; // number of nodes in the trie
+} Louds;
+
+
+/**
+ * Encode a trie (or DAWG, which is expanded back into a tree) as a LOUDS trie.
+ *
+ * @param louds pointer to the LOUDS trie to set up (free with louds_free)
+ * @param root pointer to the root node of the trie
+ * @return 0 on success, 1 on failure (due to failed malloc)
+ */
+int louds_from_trie(Louds *louds, const Trie *root);
+
+
+/**
+ * Free the memory used by a LOUDS trie.
+ *
+ * @param louds pointer to the LOUDS trie
+ */
+void louds_free(Louds *louds);
+
+
+/**
+ * Get the number of bytes used by a LOUDS trie.
+ *
+ * @param louds pointer to the LOUDS trie
+ * @return the total size of the bit vectors and index
+ */
+size_t louds_size(const Louds *louds);
+
+
+/**
+ * Step from a node to one of its children.
+ *
+ * @param louds pointer to the LOUDS trie
+ * @param node the node number
+ * @param ch the letter of the child (must be a lowercase letter)
+ * @return the node number of the child, or LOUDS_NONE if there is no such child
+ */
+uint32_t louds_step(const Louds *louds, uint32_t node, char ch);
+
+
+/**
+ * Check if a node is the end of a word.
+ *
+ * @param louds pointer to the LOUDS trie
+ * @param node the node number
+ * @return 1 if the node is the end of a word, 0 otherwise
+ */
+int louds_is_word(const Louds *louds, uint32_t node);
+
+
+/**
+ * Check if any words continue past a node.
+ *
+ * @param louds pointer to the LOUDS trie
+ * @param node the node number
+ * @return 1 if the node has any children, 0 otherwise
+ */
+int louds_has_children(const Louds *louds, uint32_t node);
+
+
+/**
+ * Check if a word is in the LOUDS trie.
+ *
+ * @param louds pointer to the LOUDS trie
+ * @param word the word to find (null-terminated string)
+ * @param prefix whether to count a prefix as valid (1) or a require full word match (0)
+ * @return 1 if the word is in the trie, 0 otherwise
+ */
+int louds_contains(const Louds *louds, const char *word, int prefix);
+
+
+#endif //LOUDS_H
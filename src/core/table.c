@@ -0,0 +1,210 @@
+#include "table.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+static_assert(sizeof(TableHeader) % 4 == 0, "table entries must be aligned in a file");
+static_assert(SIZE * MAX_LETTER_SCORE < 256, "scores must fit in the bottom byte of an entry");
+
+
+/**
+ * Compute a binomial coefficient.
+ *
+ * @param n the size of the set
+ * @param k the size of the subsets
+ * @return the number of subsets of size k
+ */
+static uint32_t binomial(const uint32_t n, const uint32_t k) {
+  if (k > n) {
+    return 0;
+  }
+
+  // each partial product is itself a binomial coefficient, so the division is always exact
+  uint64_t result = 1;
+  for (uint32_t i = 0; i < k; i++) {
+    result = result * (n - i) / (i + 1);
+  }
+
+  return (uint32_t) result;
+}
+
+
+/**
+ * Get the number of bytes taken up by the words in a table file.
+ *
+ * @param num_words the number of words
+ * @return the size of the words, padded so that the entries are aligned
+ */
+static size_t words_size(const uint32_t num_words) {
+  return ((size_t) num_words * (SIZE + 1) + 3) / 4 * 4;
+}
+
+
+uint32_t table_num_racks(void) {
+  // choosing SIZE tiles with repetition is the same as choosing SIZE distinct items from TABLE_SYMBOLS + SIZE - 1
+  return binomial(TABLE_SYMBOLS + SIZE - 1, SIZE);
+}
+
+
+uint32_t table_rank(const int counts[TABLE_SYMBOLS]) {
+  /* spread the sorted tiles out into distinct positions, then rank them as a combination */
+  uint32_t rank = 0;
+  uint32_t i = 0;
+  for (uint32_t symbol = 0; symbol < TABLE_SYMBOLS; symbol++) {
+    for (int c = 0; c < counts[symbol]; c++, i++) {
+      rank += binomial(symbol + i, i + 1);
+    }
+  }
+
+  return rank;
+}
+
+
+void table_unrank(uint32_t rank, int counts[TABLE_SYMBOLS]) {
+  memset(counts, 0, TABLE_SYMBOLS * sizeof(int));
+
+  /* peel off the largest position first, which is the largest binomial coefficient that fits */
+  uint32_t position = TABLE_SYMBOLS + SIZE - 1;
+  for (uint32_t i = SIZE; i-- > 0;) {
+    do {
+      position--;
+    } while (binomial(position, i + 1) > rank);
+
+    rank -= binomial(position, i + 1);
+    counts[position - i]++;
+  }
+}
+
+
+int table_open(Table *table, const char *path, const uint32_t dict_checksum) {
+  /* map the whole file */
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return 1;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) || st.st_size < (off_t) sizeof(TableHeader)) {
+    close(fd);
+    return 1;
+  }
+
+  const size_t size = (size_t) st.st_size;
+  void *map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd); // the mapping stays valid after the file is closed
+  if (map == MAP_FAILED) {
+    return 1;
+  }
+
+  /* check that the header matches this build and dictionary */
+  const TableHeader *header = map;
+  if (
+    memcmp(header->magic, TABLE_MAGIC, sizeof(header->magic)) ||
+    header->byte_order != TABLE_BYTE_ORDER ||
+    header->version != TABLE_VERSION ||
+    header->size != SIZE ||
+    header->store != STORE ||
+    header->num_racks != table_num_racks() ||
+    header->dict_checksum != dict_checksum
+  ) {
+    munmap(map, size);
+    return 2;
+  }
+
+  /* check that the file is complete (the entries themselves are checked as they are looked up) */
+  const size_t expected = sizeof(TableHeader) + words_size(header->num_words) +
+                          (size_t) header->num_racks * STORE * sizeof(uint32_t);
+  if (size != expected) {
+    munmap(map, size);
+    return 3;
+  }
+
+  table->words = (const char *) (header + 1);
+  table->entries = (const uint32_t *) (table->words + words_size(header->num_words));
+  table->num_words = header->num_words;
+  table->num_racks = header->num_racks;
+  table->map = map;
+  table->map_size = size;
+
+  return 0;
+}
+
+
+int table_write(const char *path, const uint32_t dict_checksum, const char *words, const uint32_t num_words,
+                const uint32_t *entries) {
+  TableHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, TABLE_MAGIC, sizeof(TABLE_MAGIC));
+  header.byte_order = TABLE_BYTE_ORDER;
+  header.version = TABLE_VERSION;
+  header.size = SIZE;
+  header.store = STORE;
+  header.dict_checksum = dict_checksum;
+  header.num_words = num_words;
+  header.num_racks = table_num_racks();
+
+  FILE *fp = fopen(path, "wb");
+  if (!fp) {
+    return 1;
+  }
+
+  const size_t num_chars = (size_t) num_words * (SIZE + 1);
+  const char padding[4] = {0};
+  const size_t num_entries = (size_t) header.num_racks * STORE;
+  int err = fwrite(&header, sizeof(header), 1, fp) != 1;
+  err |= fwrite(words, 1, num_chars, fp) != num_chars;
+  err |= fwrite(padding, 1, words_size(num_words) - num_chars, fp) != words_size(num_words) - num_chars;
+  err |= fwrite(entries, sizeof(uint32_t), num_entries, fp) != num_entries;
+  err |= fclose(fp) != 0;
+  if (err) {
+    remove(path);
+    return 1;
+  }
+
+  return 0;
+}
+
+
+void table_free(Table *table) {
+  if (table->map) {
+    munmap(table->map, table->map_size);
+  }
+
+  memset(table, 0, sizeof(Table));
+}
+
+
+int table_lookup(const Table *table, const int counts[TABLE_SYMBOLS], char top_words[STORE][SIZE + 1],
+                 int top_scores[STORE]) {
+  const uint32_t *entries = table->entries + (size_t) table_rank(counts) * STORE;
+  if (entries[0] == TABLE_UNSOLVED) {
+    return 0;
+  }
+
+  /* check every word is in the table before using any of them */
+  for (int i = 0; i < STORE; i++) {
+    const uint32_t word = entries[i] >> 8;
+    if (word != TABLE_NO_WORD && word >= table->num_words) {
+      return 0;
+    }
+  }
+
+  for (int i = 0; i < STORE; i++) {
+    const uint32_t word = entries[i] >> 8;
+    memset(top_words[i], 0, SIZE + 1);
+    top_scores[i] = 0;
+
+    if (word != TABLE_NO_WORD) {
+      memcpy(top_words[i], table->words + (size_t) word * (SIZE + 1), SIZE);
+      top_scores[i] = (int) (entries[i] & 0xFF);
+    }
+  }
+
+  return 1;
+}
@@ -0,0 +1,129 @@
+#ifndef TABLE_H
+#define TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "src/core/game_tileset.h"
+
+
+#define TABLE_MAGIC ("PZLTABL") // identifies a solution table file (including the null-terminator)
+#define TABLE_VERSION (1) // bumped whenever the layout of a solution table file changes
+#define TABLE_BYTE_ORDER (0x01020304u) // written in native byte order to detect foreign files
+#define TABLE_SYMBOLS (27) // number of different tiles (the letters, then the blank)
+
+#define TABLE_NO_WORD (0xFFFFFFu) // word index of an unused slot in a rack's list of best words
+#define TABLE_UNSOLVED (0xFFFFFFFFu) // first entry for a rack that is not in the table
+#define TABLE_ENTRY(word, score) (((uint32_t) (word) << 8) | (uint32_t) (score)) // pack a word index and score
+
+
+/**
+ * Header at the start of a solution table file.
+ *
+ * The header is followed by the words (each taking SIZE + 1 chars, padded to a multiple of 4 bytes in total), then
+ * STORE entries for every rack in order of rank. Each entry packs the index of a word with its score (see TABLE_ENTRY).
+ */
+typedef struct TableHeader {
+  char magic[8]; // TABLE_MAGIC
+  uint32_t byte_order; // TABLE_BYTE_ORDER
+  uint32_t version; // TABLE_VERSION
+  uint32_t size; // SIZE
+  uint32_t store; // STORE
+  uint32_t dict_checksum; // checksum of the dictionary used to find the best words
+  uint32_t num_words; // number of words
+  uint32_t num_racks; // number of racks (always table_num_racks())
+} TableHeader;
+
+
+/**
+ * A read-only table of the best words for every possible rack.
+ *
+ * Racks are identified by how many of each tile they have, regardless of order, so each rack is a multiset of SIZE
+ * tiles. These are numbered from 0 using the combinatorial number system (see table_rank), which indexes the entries.
+ */
+typedef struct Table {
+  const char *words; // the words (each taking SIZE + 1 chars)
+  const uint32_t *entries; // STORE entries for each rack
+  uint32_t num_words; // number of words
+  uint32_t num_racks; // number of racks
+
+  void *map; // mapped table file
+  size_t map_size; // size of the mapped file
+} Table;
+
+
+/**
+ * Get the number of different racks.
+ *
+ * @return the number of multisets of SIZE tiles
+ */
+uint32_t table_num_racks(void);
+
+
+/**
+ * Get the rank of a rack, which is its position in the table.
+ *
+ * @param counts the number of each tile in the rack (the letters, then the blank), adding up to SIZE
+ * @return the rank, from 0 to table_num_racks() - 1
+ */
+uint32_t table_rank(const int counts[TABLE_SYMBOLS]);
+
+
+/**
+ * Get the rack with a given rank.
+ *
+ * @param rank the rank, from 0 to table_num_racks() - 1
+ * @param counts set to the number of each tile in the rack (the letters, then the blank)
+ */
+void table_unrank(uint32_t rank, int counts[TABLE_SYMBOLS]);
+
+
+/**
+ * Open a solution table file.
+ *
+ * The file is mapped read-only and used in place, so only the parts of it that are looked up are ever read.
+ *
+ * @param table pointer to the table to set up (free with table_free)
+ * @param path the file to open
+ * @param dict_checksum checksum of the dictionary in use, which the table must have been made with
+ * @return 0 on success, 1 if the file could not be read, 2 if it is not a compatible table, 3 if it is corrupt
+ */
+int table_open(Table *table, const char *path, uint32_t dict_checksum);
+
+
+/**
+ * Write a solution table file that can be loaded with table_open.
+ *
+ * @param path the file to write to
+ * @param dict_checksum checksum of the dictionary used to find the best words
+ * @param words the words (each taking SIZE + 1 chars)
+ * @param num_words the number of words
+ * @param entries STORE entries for each of the table_num_racks() racks
+ * @return 0 on success, 1 on failure
+ */
+int table_write(const char *path, uint32_t dict_checksum, const char *words, uint32_t num_words,
+                const uint32_t *entries);
+
+
+/**
+ * Unmap a solution table.
+ *
+ * @param table pointer to the table
+ */
+void table_free(Table *table);
+
+
+/**
+ * Look up the best words for a rack.
+ *
+ * @param table pointer to the table
+ * @param counts the number of each tile in the rack (the letters, then the blank)
+ * @param top_words set to the best words, from best to worst (unused slots are empty)
+ * @param top_scores set to the scores of the best words
+ * @return 1 if the rack was found, 0 if it is not in the table
+ */
+int table_lookup(const Table *table, const int counts[TABLE_SYMBOLS], char top_words[STORE][SIZE + 1],
+                 int top_scores[STORE]);
+
+
+#endif //TABLE_H
@@ -4,6 +4,7 @@
 
 #include "trie.h"
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -13,6 +14,40 @@ static_assert('z' - 'a' == 25, "alphabet chars must be contiguous");
 static_assert(NULL == 0, "NULL must be 0");
 
 
+#define TRIE_SLAB_SIZE (4096) // number of nodes in each arena slab
+#define REGISTER_SIZE (1024) // initial capacity of the register used to minimise a trie (must be a power of 2)
+
+
+/**
+ * A single block of nodes in an arena.
+ */
+struct TrieSlab {
+  struct TrieSlab *next; // the previously allocated slab (if any)
+  int used; // number of nodes handed out from this slab
+  Trie nodes[TRIE_SLAB_SIZE];
+};
+
+
+/**
+ * Node storage for an arena-backed trie.
+ */
+struct TrieArena {
+  struct TrieSlab *slabs; // the most recently allocated slab (if any)
+  Trie *spare; // nodes that have been given back to the arena (linked through children[0])
+};
+
+
+/**
+ * Set of nodes compared by value (letter, terminal flag and children), used to find equivalent nodes when minimising a
+ * trie into a DAWG.
+ */
+struct Register {
+  Trie **nodes; // open-addressed table of nodes (NULL for an empty slot)
+  size_t capacity; // size of the table (always a power of 2)
+  size_t count; // number of nodes in the table
+};
+
+
 /**
  * Set up a node with blank child information.
  *
@@ -24,15 +59,184 @@ static void setup_node(Trie *node, char letter, Trie *parent) {
   node->letter = letter;
   node->parent = parent;
   node->is_terminal = 0;
+  node->arena = NULL;
   memset(node->children, 0, sizeof(node->children));
 }
 
 
+/**
+ * Allocate a new (uninitialised) node for a trie.
+ *
+ * @param root pointer to the root node, which owns the arena (if any)
+ * @return pointer to the new node, or NULL on failure
+ */
+static Trie *new_node(Trie *root) {
+  struct TrieArena *arena = root->arena;
+  if (!arena) {
+    return malloc(sizeof(Trie));
+  }
+
+  /* reuse nodes that have been given back first */
+  if (arena->spare) {
+    Trie *node = arena->spare;
+    arena->spare = node->children[0];
+    return node;
+  }
+
+  /* start a new slab if the current one is full */
+  if (!arena->slabs || arena->slabs->used == TRIE_SLAB_SIZE) {
+    struct TrieSlab *slab = malloc(sizeof(struct TrieSlab));
+    if (!slab) {
+      return NULL;
+    }
+
+    slab->next = arena->slabs;
+    slab->used = 0;
+    arena->slabs = slab;
+  }
+
+  return arena->slabs->nodes + arena->slabs->used++;
+}
+
+
+/**
+ * Give a node back to the arena so that it can be reused.
+ *
+ * @param root pointer to the root node, which owns the arena
+ * @param node pointer to the node to release
+ */
+static void release_node(Trie *root, Trie *node) {
+  node->children[0] = root->arena->spare;
+  root->arena->spare = node;
+}
+
+
+/**
+ * Hash a node by value.
+ *
+ * @param node pointer to the node
+ * @return the hash of the letter, terminal flag and children of the node
+ */
+static size_t hash_node(const Trie *node) {
+  /* FNV-1a over the fields... */
+  uint64_t hash = 14695981039346656037u;
+  hash = (hash ^ (unsigned char) node->letter) * 1099511628211u;
+  hash = (hash ^ node->is_terminal) * 1099511628211u;
+  for (int i = 0; i < 26; i++) {
+    hash = (hash ^ (uintptr_t) node->children[i]) * 1099511628211u;
+  }
+
+  /* ...then mix the high bits down, since the table is indexed by the low bits */
+  hash ^= hash >> 32;
+  hash *= 0xD6E8FEB86659FD93u;
+  hash ^= hash >> 32;
+
+  return (size_t) hash;
+}
+
+
+/**
+ * Find the slot in a register for a node.
+ *
+ * @param reg pointer to the register
+ * @param node pointer to the node to find
+ * @return pointer to the slot holding an equivalent node, or to the empty slot where it belongs
+ */
+static Trie **register_find(const struct Register *reg, const Trie *node) {
+  size_t i = hash_node(node) & (reg->capacity - 1);
+  while (reg->nodes[i]) {
+    const Trie *other = reg->nodes[i];
+    if (
+      other->letter == node->letter &&
+      other->is_terminal == node->is_terminal &&
+      !memcmp(other->children, node->children, sizeof(node->children))
+    ) {
+      break;
+    }
+    i = (i + 1) & (reg->capacity - 1);
+  }
+
+  return reg->nodes + i;
+}
+
+
+/**
+ * Double the capacity of a register.
+ *
+ * @param reg pointer to the register
+ * @return 0 on success, 1 on failure (due to failed malloc)
+ */
+static int register_grow(struct Register *reg) {
+  const struct Register old = *reg;
+
+  reg->capacity = 2 * old.capacity;
+  reg->nodes = calloc(reg->capacity, sizeof(Trie *));
+  if (!reg->nodes) {
+    *reg = old;
+    return 1;
+  }
+
+  for (size_t i = 0; i < old.capacity; i++) {
+    if (old.nodes[i]) {
+      *register_find(reg, old.nodes[i]) = old.nodes[i];
+    }
+  }
+  free(old.nodes);
+
+  return 0;
+}
+
+
+/**
+ * Minimise the most recently added branch below a node.
+ *
+ * Every node on the branch is either replaced by an equivalent node from the register (and given back to the arena),
+ * or added to the register itself.
+ *
+ * @param root pointer to the root node, which owns the arena
+ * @param reg pointer to the register of minimised nodes
+ * @param node pointer to the node whose last child should be minimised
+ * @return 0 on success, 1 on failure (due to failed malloc)
+ */
+static int replace_or_register(Trie *root, struct Register *reg, Trie *node) {
+  /* the most recently added child is the last one alphabetically */
+  int i = 25;
+  while (i >= 0 && !node->children[i]) {
+    i--;
+  }
+  if (i < 0) {
+    return 0;
+  }
+  Trie *child = node->children[i];
+
+  /* equivalence is decided by comparing child pointers, so the descendants must be minimised first */
+  if (replace_or_register(root, reg, child)) {
+    return 1;
+  }
+
+  Trie **slot = register_find(reg, child);
+  if (*slot) {
+    node->children[i] = *slot;
+    release_node(root, child);
+    return 0;
+  }
+
+  *slot = child;
+  reg->count++;
+  if (2 * reg->count > reg->capacity) {
+    return register_grow(reg);
+  }
+
+  return 0;
+}
+
+
 Trie trie_root(void) {
   Trie root = {
     .letter = '\0',
     .parent = NULL,
     .is_terminal = 0,
+    .arena = NULL,
   };
   memset(root.children, 0, sizeof(root.children));
 
@@ -40,7 +244,96 @@ Trie trie_root(void) {
 }
 
 
+int trie_init_arena(Trie *root) {
+  setup_node(root, '\0', NULL);
+
+  root->arena = malloc(sizeof(struct TrieArena));
+  if (!root->arena) {
+    return 1;
+  }
+  root->arena->slabs = NULL;
+  root->arena->spare = NULL;
+
+  return 0;
+}
+
+
+int trie_init_dawg(Trie *root, const char **words, const int num_words) {
+  if (trie_init_arena(root)) {
+    return 1;
+  }
+
+  struct Register reg = {
+    .nodes = calloc(REGISTER_SIZE, sizeof(Trie *)),
+    .capacity = REGISTER_SIZE,
+    .count = 0,
+  };
+  if (!reg.nodes) {
+    trie_destroy(root);
+    return 1;
+  }
+
+  int err = 0;
+  const char *prev = "";
+  for (int w = 0; w < num_words && !err; w++) {
+    const char *word = words[w];
+    if (strcmp(prev, word) >= 0) {
+      err = 2;
+      break;
+    }
+
+    /* follow the prefix shared with the previous word */
+    Trie *node = root;
+    int i = 0;
+    while (prev[i] == word[i]) {
+      node = node->children[TRIE_IDX(word[i])];
+      i++;
+    }
+
+    /* nothing more can be added below the rest of the previous word, so it can be minimised */
+    if (replace_or_register(root, &reg, node)) {
+      err = 1;
+      break;
+    }
+
+    /* add the rest of this word */
+    for (; word[i] != '\0'; i++) {
+      Trie *child = new_node(root);
+      if (!child) {
+        err = 1;
+        break;
+      }
+
+      setup_node(child, word[i], node);
+      node->children[TRIE_IDX(word[i])] = child;
+      node = child;
+    }
+    node->is_terminal = 1;
+
+    prev = word;
+  }
+
+  /* minimise the final word */
+  if (!err) {
+    err = replace_or_register(root, &reg, root);
+  }
+
+  free(reg.nodes);
+  if (err) {
+    trie_destroy(root);
+  }
+
+  return err;
+}
+
+
 void trie_free(Trie *root) {
+  /* arena-backed nodes can only be freed all at once */
+  if (root->arena) {
+    trie_destroy(root);
+    return;
+  }
+
   for (int i = 0; i < 26; i++) {
     // only free if the child exists
     if (root->children[i]) {
@@ -55,15 +348,37 @@ void trie_free(Trie *root) {
 }
 
 
+void trie_destroy(Trie *root) {
+  struct TrieArena *arena = root->arena;
+  if (!arena) {
+    trie_free(root);
+    return;
+  }
+
+  /* every node lives in a slab, so there is no need to walk the trie */
+  struct TrieSlab *slab = arena->slabs;
+  while (slab) {
+    struct TrieSlab *next = slab->next;
+    free(slab);
+    slab = next;
+  }
+  free(arena);
+
+  root->arena = NULL;
+  root->is_terminal = 0;
+  memset(root->children, 0, sizeof(root->children));
+}
+
+
 int trie_insert(Trie *root, const char *word) {
   Trie *node = root;
 
-  for (int i = 0; i < (int)strlen(word); i++) {
+  for (int i = 0; word[i] != '\0'; i++) {
     const char ch = word[i];
 
     /* add a child to the node if it doesn't araedy have one for ch */
     if (!node->children[TRIE_IDX(ch)]) {
-      node->children[ch - 'a'] = malloc(sizeof(Trie));
+      node->children[TRIE_IDX(ch)] = new_node(root);
 
       if (!node->children[TRIE_IDX(ch)]) {
         return 1;
@@ -84,19 +399,37 @@ int trie_insert(Trie *root, const char *word) {
 
 
 int trie_contains(Trie *root, const char *word, int prefix) {
-  Trie *node = root;
-
-  for (int i = 0; i < (int)strlen(word); i++) {
-    const char ch = word[i];
+  const Trie *node = root;
 
+  for (int i = 0; word[i] != '\0'; i++) {
     /* only keep going if the correct child node exists */
-    if (node->children[TRIE_IDX(ch)]) {
-      node = node->children[TRIE_IDX(ch)];
-    } else {
+    node = trie_step(node, word[i]);
+    if (!node) {
       return 0;
     }
   }
 
   /* the word is in the trie, but is it a full word? */
-  return prefix || node->is_terminal;
+  return prefix || trie_is_word(node);
+}
+
+
+Trie *trie_step(const Trie *node, const char ch) {
+  return node->children[TRIE_IDX(ch)];
+}
+
+
+int trie_is_word(const Trie *node) {
+  return node->is_terminal;
+}
+
+
+int trie_has_children(const Trie *node) {
+  for (int i = 0; i < 26; i++) {
+    if (node->children[i]) {
+      return 1;
+    }
+  }
+
+  return 0;
 }
@@ -7,6 +7,11 @@
 
 #include <stdbool.h>
 
+
+/* block storage for the nodes of an arena-backed trie (see trie_init_arena) */
+struct TrieArena;
+
+
 typedef struct Trie {
   /* the letter held by this node */
   char letter;
@@ -19,6 +24,9 @@ typedef struct Trie {
 
   /* whether this represents the end of a word */
   bool is_terminal;
+
+  /* node storage owned by this trie (root only, NULL if nodes are malloc'd individually) */
+  struct TrieArena *arena;
 } Trie;
 
 
@@ -33,6 +41,35 @@ typedef struct Trie {
 Trie trie_root(void);
 
 
+/**
+ * Sets up a new trie root node whose descendants are allocated in blocks.
+ *
+ * Nodes are carved out of large slabs owned by the root rather than being malloc'd one at a time, and are all
+ * released together by trie_destroy. If the arena cannot be allocated then the root is still set up, but falls back
+ * to allocating each node individually.
+ *
+ * @param root pointer to the root node to set up
+ * @return 0 on success, 1 on failure (due to failed malloc)
+ */
+int trie_init_arena(Trie *root);
+
+
+/**
+ * Sets up a new trie root node holding a minimised DAWG (directed acyclic word graph) of a sorted list of words.
+ *
+ * Equivalent suffixes (such as "-ing" or "-s") are merged as the words are added, so nodes may have more than one
+ * parent (the parent pointer only records the first). The result answers trie_contains exactly like a trie of the same
+ * words, but has far fewer nodes. The nodes live in an arena (see trie_init_arena), and must not be modified with
+ * trie_insert.
+ *
+ * @param root pointer to the root node to set up (free with trie_destroy)
+ * @param words the words to add, in strictly increasing order
+ * @param num_words the number of words
+ * @return 0 on success, 1 on failure (due to failed malloc), 2 if the words are not sorted
+ */
+int trie_init_dawg(Trie *root, const char **words, int num_words);
+
+
 /**
  * Frees the memory used by the trie, not including this node.
  *
@@ -41,6 +78,16 @@ Trie trie_root(void);
 void trie_free(Trie *root);
 
 
+/**
+ * Frees all of the nodes in the trie (in a single pass for arena-backed tries), along with any arena.
+ *
+ * The root node itself is left as an empty trie.
+ *
+ * @param root pointer to the root node
+ */
+void trie_destroy(Trie *root);
+
+
 /**
  * Create a new trie node.
  *
@@ -62,6 +109,34 @@ int trie_insert(Trie *root, const char *word);
 int trie_contains(Trie *root, const char *word, int prefix);
 
 
+/**
+ * Step from a node to one of its children.
+ *
+ * @param node pointer to the node
+ * @param ch the letter of the child (must be a lowercase letter)
+ * @return pointer to the child, or NULL if there is no such child
+ */
+Trie *trie_step(const Trie *node, char ch);
+
+
+/**
+ * Check if a node is the end of a word.
+ *
+ * @param node pointer to the node
+ * @return 1 if the node is the end of a word, 0 otherwise
+ */
+int trie_is_word(const Trie *node);
+
+
+/**
+ * Check if any words continue past a node.
+ *
+ * @param node pointer to the node
+ * @return 1 if the node has any children, 0 otherwise
+ */
+int trie_has_children(const Trie *node);
+
+
 /**
  * Get the word from a node and all of its parents.
  *
@@ -1,5 +1,6 @@
 #include "testing.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 #include "src/core/game_2048.h"
@@ -296,5 +297,68 @@ int main(void) {
     for (int i = 0; i < 16; i++) REQUIRE(answer63[i] == game.grid[i]);
   }
 
+  /* check that a single line is slid and merged in one pass, in either direction through memory */
+  SUBTEST("slide line") {
+    int line[4] = {1, 1, 1, 1};
+    int score = 0;
+    REQUIRE(slide_line_2048(line, 1, &score) == 1);
+    REQUIRE(line[0] == 2 && line[1] == 2 && line[2] == 0 && line[3] == 0);
+    REQUIRE(score == 2 * 4);
+
+    int backwards[4] = {2, 0, 1, 1};
+    score = 0;
+    REQUIRE(slide_line_2048(backwards + 3, -1, &score) == 1);
+    REQUIRE(backwards[0] == 0 && backwards[1] == 0 && backwards[2] == 2 && backwards[3] == 2);
+    REQUIRE(score == 4);
+
+    int stuck[4] = {3, 2, 3, 0};
+    score = 0;
+    REQUIRE(slide_line_2048(stuck, 1, &score) == 0);
+    REQUIRE(stuck[0] == 3 && stuck[1] == 2 && stuck[2] == 3 && stuck[3] == 0);
+    REQUIRE(score == 0);
+
+    int column[16] = {0};
+    column[1] = 20;
+    column[9] = 20;
+    column[13] = 20;
+    REQUIRE(slide_line_2048(column + 1, 4, &score) == 1);
+    REQUIRE(column[1] == 21 && column[5] == 20 && column[9] == 0 && column[13] == 0);
+    REQUIRE(score == (1 << 21) * 20);
+  }
+
+  /* check that a seeded game adds the same tiles for the same moves, whatever rand is doing */
+  SUBTEST("seeded") {
+    struct Game other;
+    srand(1);
+    reset_seeded_2048(&game, 42);
+    srand(2);
+    reset_seeded_2048(&other, 42);
+    REQUIRE(game.nz == SIZE * SIZE - 2);
+    REQUIRE(memcmp(game.grid, other.grid, sizeof(game.grid)) == 0);
+
+    const Move moves[4] = {UP, LEFT, DOWN, RIGHT};
+    for (int i = 0; i < 200 && game.status == PLAYING; i++) {
+      const Result result = turn_2048(&game, moves[i % 4]);
+      REQUIRE(turn_2048(&other, moves[i % 4]) == result);
+    }
+    REQUIRE(memcmp(game.grid, other.grid, sizeof(game.grid)) == 0);
+    REQUIRE(game.score == other.score && game.turn == other.turn);
+    REQUIRE(game.turn > 0);
+
+    /* different seeds give different games */
+    reset_seeded_2048(&other, 43);
+    int differs = 0;
+    for (int seed = 0; seed < 10; seed++) {
+      reset_seeded_2048(&game, (uint64_t) seed);
+      differs |= memcmp(game.grid, other.grid, sizeof(game.grid)) != 0;
+    }
+    REQUIRE(differs);
+
+    /* resetting normally goes back to rand */
+    reset_2048(&game);
+    REQUIRE(game.rng == 0);
+    REQUIRE(game.nz == SIZE * SIZE - 2);
+  }
+
   END_TEST();
 }
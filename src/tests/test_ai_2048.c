@@ -0,0 +1,155 @@
+#include "testing.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/core/ai_2048.h"
+#include "src/core/board_2048.h"
+#include "src/core/game_2048.h"
+
+
+int main(void) {
+  START_TEST("ai_2048");
+
+  struct Ai *ai = start_ai_2048();
+  REQUIRE_BARRIER(ai != NULL);
+
+  struct Game game;
+  Move move;
+  int depth;
+  long nodes;
+
+  /* the only move that does anything is chosen */
+  SUBTEST("only move") {
+    int grid[16] = {
+      1, 2, 1, 2,
+      2, 1, 2, 1,
+      1, 2, 1, 2,
+      2, 1, 2, 0,
+    };
+    memset(&game, 0, sizeof(game));
+    memcpy(game.grid, grid, sizeof(grid));
+
+    REQUIRE(best_move_2048(ai, &game, 10000, &move) == 0);
+    REQUIRE(move == DOWN || move == RIGHT);
+    stats_ai_2048(ai, &depth, &nodes);
+    REQUIRE(depth >= 1);
+  }
+
+  /* a full grid with no pairs has no moves */
+  SUBTEST("game over") {
+    int grid[16] = {
+      1, 2, 1, 2,
+      2, 1, 2, 1,
+      1, 2, 1, 2,
+      2, 1, 2, 1,
+    };
+    memset(&game, 0, sizeof(game));
+    memcpy(game.grid, grid, sizeof(grid));
+
+    REQUIRE(best_move_2048(ai, &game, 10000, &move) == 1);
+  }
+
+  /* merging the pair of big tiles beats leaving them apart */
+  SUBTEST("big merge") {
+    int grid[16] = {
+      9, 9, 3, 1,
+      3, 2, 1, 2,
+      1, 3, 2, 3,
+      2, 1, 3, 0,
+    };
+    memset(&game, 0, sizeof(game));
+    memcpy(game.grid, grid, sizeof(grid));
+
+    REQUIRE(best_move_2048(ai, &game, 50000, &move) == 0);
+    REQUIRE(move == LEFT || move == RIGHT);
+  }
+
+  /* tiles too big for a board still get a move */
+  SUBTEST("big tiles") {
+    memset(&game, 0, sizeof(game));
+    game.grid[0] = BOARD_MAX_TILE + 1;
+    game.grid[1] = 1;
+
+    REQUIRE(best_move_2048(ai, &game, 10000, &move) == 0);
+    struct Game copy = game;
+    REQUIRE(move_2048(&copy, move) == MOVE_SUCCESS);
+  }
+
+  /* a longer budget searches at least as deep (how long each search takes is left to sim2048, as it depends on the
+   * build and the machine) */
+  SUBTEST("deadline") {
+    int grid[16] = {
+      1, 0, 2, 0,
+      0, 3, 0, 1,
+      4, 0, 0, 2,
+      0, 1, 5, 0,
+    };
+    memset(&game, 0, sizeof(game));
+    memcpy(game.grid, grid, sizeof(grid));
+
+    REQUIRE(best_move_2048(ai, &game, 1000, &move) == 0);
+    stats_ai_2048(ai, &depth, &nodes);
+    REQUIRE(depth >= 1);
+    REQUIRE(nodes > 0);
+    const int short_depth = depth;
+    const long short_nodes = nodes;
+
+    REQUIRE(best_move_2048(ai, &game, 100000, &move) == 0);
+    stats_ai_2048(ai, &depth, &nodes);
+    REQUIRE(depth >= short_depth);
+    REQUIRE(depth >= 3);
+    REQUIRE(nodes >= short_nodes);
+  }
+
+  /* a short game played by the search reaches a tile that random moves rarely do */
+  SUBTEST("play") {
+    srand(2048);
+    reset_2048(&game);
+    int largest = 0;
+    while (game.status == PLAYING && largest < 9) {
+      REQUIRE_BARRIER(best_move_2048(ai, &game, 2000, &move) == 0);
+      turn_2048(&game, move);
+      for (int i = 0; i < 16; i++) {
+        largest = game.grid[i] > largest ? game.grid[i] : largest;
+      }
+    }
+    REQUIRE(largest >= 9);
+  }
+
+  /* several threads share the search, and still find the big merge */
+  SUBTEST("threads") {
+    REQUIRE(set_threads_ai_2048(ai, 4) == 4);
+    REQUIRE(set_threads_ai_2048(ai, AI_MAX_THREADS + 1) == AI_MAX_THREADS);
+    REQUIRE(set_threads_ai_2048(ai, 0) >= 1);
+    set_threads_ai_2048(ai, 4);
+
+    int grid[16] = {
+      9, 9, 3, 1,
+      3, 2, 1, 2,
+      1, 3, 2, 3,
+      2, 1, 3, 0,
+    };
+    memset(&game, 0, sizeof(game));
+    memcpy(game.grid, grid, sizeof(grid));
+
+    REQUIRE(best_move_2048(ai, &game, 50000, &move) == 0);
+    REQUIRE(move == LEFT || move == RIGHT);
+    stats_ai_2048(ai, &depth, &nodes);
+    REQUIRE(depth >= 3);
+    REQUIRE(nodes > 0);
+
+    /* the waiting threads can be changed between searches, and are reused by each one */
+    const int counts[4] = {2, 3, 1, 4};
+    for (int i = 0; i < 4; i++) {
+      REQUIRE(set_threads_ai_2048(ai, counts[i]) == counts[i]);
+      for (int j = 0; j < 3; j++) {
+        REQUIRE(best_move_2048(ai, &game, 5000, &move) == 0);
+        REQUIRE(move == LEFT || move == RIGHT);
+      }
+    }
+  }
+
+  free_ai_2048(ai);
+  END_TEST();
+}
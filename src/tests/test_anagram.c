@@ -0,0 +1,92 @@
+#include "testing.h"
+
+#include <string.h>
+
+#include "src/core/anagram.h"
+#include "src/core/dict.h"
+#include "src/core/game_tileset.h"
+#include "src/core/trie.h"
+
+
+static const char SCORES[26] = LETTER_SCORES;
+
+
+/**
+ * Get the signature of a word.
+ *
+ * @param word the word
+ * @return the signature of its letters
+ */
+static uint64_t signature_of(const char *word) {
+  int counts[26] = {0};
+  for (int i = 0; word[i] != '\0'; i++) {
+    counts[word[i] - 'a']++;
+  }
+
+  return anagram_signature(counts);
+}
+
+
+int main(void) {
+  START_TEST("anagram");
+
+  /* check that only the letters (and not their order) make up a signature */
+  SUBTEST("signature") {
+    REQUIRE(signature_of("") == 0);
+    REQUIRE(signature_of("a") != 0);
+    REQUIRE(signature_of("a") != signature_of("aa"));
+    REQUIRE(signature_of("ab") == signature_of("ba"));
+    REQUIRE(signature_of("listen") == signature_of("silent"));
+    REQUIRE(signature_of("listen") != signature_of("listed"));
+    REQUIRE(signature_of("zzzzzzzzzzzz") != 0); // as long as can be indexed
+    REQUIRE(signature_of("zzzzzzzzzzzzz") == 0); // too long
+  }
+
+  /* check that words are grouped with their anagrams */
+  SUBTEST("find") {
+    const char *words[7] = {"act", "cat", "dog", "god", "good", "tac", "toolong"};
+
+    Trie root;
+    REQUIRE_BARRIER(trie_init_dawg(&root, words, 7) == 0);
+    Dict dict;
+    REQUIRE_BARRIER(dict_from_trie(&dict, &root, SCORES) == 0);
+    trie_destroy(&root);
+
+    Anagram anagram;
+    REQUIRE_BARRIER(anagram_from_dict(&anagram, &dict, 4) == 0);
+    REQUIRE(anagram.num_words == 6);
+
+    uint32_t count;
+    const char *found = anagram_find(&anagram, signature_of("tca"), &count);
+    REQUIRE_BARRIER(found && count == 3);
+    REQUIRE(strcmp(found, "act") == 0);
+    REQUIRE(strcmp(found + 5, "cat") == 0);
+    REQUIRE(strcmp(found + 10, "tac") == 0);
+
+    found = anagram_find(&anagram, signature_of("ogd"), &count);
+    REQUIRE_BARRIER(found && count == 2);
+    REQUIRE(strcmp(found, "dog") == 0);
+    REQUIRE(strcmp(found + 5, "god") == 0);
+
+    found = anagram_find(&anagram, signature_of("oodg"), &count);
+    REQUIRE_BARRIER(found && count == 1);
+    REQUIRE(strcmp(found, "good") == 0);
+
+    REQUIRE(anagram_find(&anagram, signature_of("goo"), &count) == NULL);
+    REQUIRE(count == 0);
+    REQUIRE(anagram_find(&anagram, signature_of("toolong"), &count) == NULL); // longer than the index
+    REQUIRE(anagram_find(&anagram, 0, &count) == NULL);
+
+    anagram_free(&anagram);
+    REQUIRE(anagram.words == NULL);
+    REQUIRE(anagram.buckets == NULL);
+
+    /* lengths that cannot be indexed */
+    REQUIRE(anagram_from_dict(&anagram, &dict, 0) == 1);
+    REQUIRE(anagram_from_dict(&anagram, &dict, ANAGRAM_MAX_LEN + 1) == 1);
+
+    dict_free(&dict);
+  }
+
+  END_TEST();
+}
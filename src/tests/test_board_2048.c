@@ -0,0 +1,159 @@
+#include "testing.h"
+
+#include <string.h>
+
+#include "src/core/board_2048.h"
+#include "src/core/game_2048.h"
+
+
+/**
+ * Move a grid one line at a time, as a reference for the row tables.
+ *
+ * @param grid the grid to move
+ * @param move the direction to move the tiles
+ * @return the score gained from the merges
+ */
+static int reference_move(int grid[SIZE * SIZE], const Move move) {
+  int score = 0;
+  for (int k = 0; k < SIZE; k++) {
+    /* find the cells of this line, starting from the side the tiles move towards */
+    int cells[SIZE];
+    for (int j = 0; j < SIZE; j++) {
+      switch (move) {
+        case LEFT:
+          cells[j] = SIZE * k + j;
+          break;
+        case RIGHT:
+          cells[j] = SIZE * k + SIZE - 1 - j;
+          break;
+        case UP:
+          cells[j] = SIZE * j + k;
+          break;
+        case DOWN:
+          cells[j] = SIZE * (SIZE - 1 - j) + k;
+          break;
+      }
+    }
+
+    /* each tile merges with the one before it, unless that tile has already merged */
+    int out[SIZE] = {0};
+    int n = 0;
+    int last_merged = 1;
+    for (int j = 0; j < SIZE; j++) {
+      const int tile = grid[cells[j]];
+      if (tile == 0) {
+        continue;
+      }
+
+      if (!last_merged && out[n - 1] == tile) {
+        out[n - 1]++;
+        score += (1 << out[n - 1]) * (out[n - 1] - 1);
+        last_merged = 1;
+      } else {
+        out[n++] = tile;
+        last_merged = 0;
+      }
+    }
+
+    for (int j = 0; j < SIZE; j++) {
+      grid[cells[j]] = out[j];
+    }
+  }
+
+  return score;
+}
+
+
+int main(void) {
+  START_TEST("board_2048");
+  board_init();
+
+  /* check that boards hold the same grid */
+  SUBTEST("pack") {
+    int grid[16] = {
+      0, 1, 2, 3,
+      4, 5, 6, 7,
+      8, 9, 10, 11,
+      12, 13, 14, 15,
+    };
+    REQUIRE(board_fits(grid));
+    const Board board = board_from_grid(grid);
+    REQUIRE(board == 0xFEDCBA9876543210ull);
+    REQUIRE(board_count_empty(board) == 1);
+
+    int unpacked[16];
+    board_to_grid(board, unpacked);
+    REQUIRE(memcmp(grid, unpacked, sizeof(grid)) == 0);
+
+    /* transposing swaps rows and columns */
+    int transposed[16];
+    board_to_grid(board_transpose(board), transposed);
+    for (int i = 0; i < SIZE; i++) {
+      for (int j = 0; j < SIZE; j++) {
+        REQUIRE(transposed[SIZE * i + j] == grid[SIZE * j + i]);
+      }
+    }
+    REQUIRE(board_transpose(board_transpose(board)) == board);
+
+    REQUIRE(board_count_empty(0) == 16);
+    REQUIRE(board_count_empty(0x1000000000000008ull) == 14);
+
+    grid[0] = BOARD_MAX_TILE + 1;
+    REQUIRE(!board_fits(grid));
+    grid[0] = -1;
+    REQUIRE(!board_fits(grid));
+  }
+
+  /* check every possible row in every direction against the reference */
+  SUBTEST("every row") {
+    const Move moves[4] = {UP, DOWN, LEFT, RIGHT};
+    int bad = 0;
+    for (uint32_t row = 0; row <= 0xFFFF; row++) {
+      // the other lines are filled with different rows, so every line position is covered
+      const Board board = row | (Board) ((row * 40503u) & 0xFFFF) << 16 |
+                          (Board) ((row ^ 0xA5A5u) & 0xFFFF) << 32 | (Board) ((row * 257u + 1) & 0xFFFF) << 48;
+
+      for (int m = 0; m < 4; m++) {
+        int expected[16];
+        board_to_grid(board, expected);
+        const int expected_score = reference_move(expected, moves[m]);
+
+        Board moved;
+        int score;
+        const int err = board_move(board, moves[m], &moved, &score);
+
+        if (!board_fits(expected)) {
+          bad += err != 1;
+          continue;
+        }
+
+        int grid[16];
+        board_to_grid(moved, grid);
+        bad += err != 0 || score != expected_score || memcmp(grid, expected, sizeof(grid)) != 0;
+      }
+    }
+    REQUIRE(bad == 0);
+  }
+
+  /* check that the game falls back to moving the grid when a tile is too big for a board */
+  SUBTEST("big tiles") {
+    struct Game game;
+    memset(&game, 0, sizeof(game));
+    game.grid[0] = BOARD_MAX_TILE;
+    game.grid[1] = BOARD_MAX_TILE;
+    REQUIRE(move_2048(&game, LEFT) == MOVE_SUCCESS);
+    REQUIRE(game.grid[0] == BOARD_MAX_TILE + 1);
+    REQUIRE(game.grid[1] == 0);
+    REQUIRE(game.score == (1 << (BOARD_MAX_TILE + 1)) * BOARD_MAX_TILE);
+
+    REQUIRE(move_2048(&game, RIGHT) == MOVE_SUCCESS);
+    REQUIRE(game.grid[3] == BOARD_MAX_TILE + 1);
+    REQUIRE(move_2048(&game, RIGHT) == MOVE_ERROR);
+
+    game.grid[7] = BOARD_MAX_TILE + 1;
+    REQUIRE(move_2048(&game, DOWN) == MOVE_SUCCESS);
+    REQUIRE(game.grid[15] == BOARD_MAX_TILE + 2);
+  }
+
+  END_TEST();
+}
@@ -0,0 +1,285 @@
+#include "testing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/core/dict.h"
+#include "src/core/game_tileset.h"
+#include "src/core/trie.h"
+
+
+static const char SCORES[26] = LETTER_SCORES;
+
+
+int main(void) {
+  START_TEST("dict");
+
+  /* check that flattening lays the nodes out breadth first */
+  SUBTEST("flatten") {
+    Trie root = trie_root();
+    trie_insert(&root, "a");
+    trie_insert(&root, "aa");
+    trie_insert(&root, "ab");
+    trie_insert(&root, "bc");
+
+    Dict dict;
+    REQUIRE_BARRIER(dict_from_trie(&dict, &root, SCORES) == 0);
+    trie_free(&root);
+
+    // This should create the following array:
+    //   0: ROOT -> 1, 2
+    //   1: a    -> 3, 4
+    //   2: b    -> 5
+    //   3: a
+    //   4: b
+    //   5: c
+    REQUIRE_BARRIER(dict.num_nodes == 6);
+    REQUIRE(dict.storage == dict.nodes);
+
+    const uint32_t bit_a = 1u << TRIE_IDX('a');
+    const uint32_t bit_b = 1u << TRIE_IDX('b');
+    const uint32_t bit_c = 1u << TRIE_IDX('c');
+    const uint32_t masks[6] = {
+      bit_a | bit_b,
+      bit_a | bit_b | DICT_TERMINAL,
+      bit_c,
+      DICT_TERMINAL,
+      DICT_TERMINAL,
+      DICT_TERMINAL,
+    };
+    for (int i = 0; i < 6; i++) {
+      REQUIRE(dict.nodes[i].mask == masks[i]);
+    }
+    REQUIRE(dict.nodes[0].first == 1);
+    REQUIRE(dict.nodes[1].first == 3);
+    REQUIRE(dict.nodes[2].first == 5);
+
+    /* each node knows which letters and how many more of them are needed to make a longer word */
+    const uint32_t reachable[6] = {bit_a | bit_b | bit_c, bit_a | bit_b, bit_c, 0, 0, 0};
+    const int min_remaining[6] = {1, 1, 1, 0, 0, 0};
+    const int max_score[6] = {6, 3, 3, 0, 0, 0}; // "bc", "ab" and "bc" respectively
+    for (uint32_t i = 0; i < 6; i++) {
+      REQUIRE(dict_reachable_letters(&dict, i) == reachable[i]);
+      REQUIRE(dict_min_remaining(&dict, i) == min_remaining[i]);
+      REQUIRE(dict_max_score(&dict, i) == max_score[i]);
+    }
+
+    dict_free(&dict);
+    REQUIRE(dict.nodes == NULL);
+    REQUIRE(dict.num_nodes == 0);
+  }
+
+  /* check contains works as expected */
+  SUBTEST("contains") {
+    Trie root = trie_root();
+    trie_insert(&root, "a");
+    trie_insert(&root, "aa");
+    trie_insert(&root, "ab");
+    trie_insert(&root, "bc");
+
+    Dict dict;
+    REQUIRE_BARRIER(dict_from_trie(&dict, &root, SCORES) == 0);
+    trie_free(&root);
+
+    REQUIRE(dict_contains(&dict, "a", 0));
+    REQUIRE(dict_contains(&dict, "a", 1));
+
+    REQUIRE(dict_contains(&dict, "aa", 0));
+    REQUIRE(dict_contains(&dict, "aa", 1));
+
+    REQUIRE(dict_contains(&dict, "ab", 0));
+    REQUIRE(dict_contains(&dict, "ab", 1));
+
+    REQUIRE(!dict_contains(&dict, "b", 0));
+    REQUIRE(dict_contains(&dict, "b", 1));
+
+    REQUIRE(dict_contains(&dict, "bc", 0));
+    REQUIRE(dict_contains(&dict, "bc", 1));
+
+    REQUIRE(!dict_contains(&dict, "c", 0));
+    REQUIRE(!dict_contains(&dict, "c", 1));
+
+    REQUIRE(!dict_contains(&dict, "z", 0));
+    REQUIRE(!dict_contains(&dict, "z", 1));
+
+    REQUIRE(!dict_contains(&dict, "zab", 0));
+    REQUIRE(!dict_contains(&dict, "zab", 1));
+
+    REQUIRE(!dict_contains(&dict, "aab", 1));
+    REQUIRE(!dict_contains(&dict, "A", 1)); // not a lowercase letter
+    REQUIRE(!dict_contains(&dict, "a{", 1));
+
+    dict_free(&dict);
+  }
+
+  /* check that a dictionary can be followed one letter at a time */
+  SUBTEST("step") {
+    Trie root = trie_root();
+    trie_insert(&root, "a");
+    trie_insert(&root, "ab");
+    trie_insert(&root, "bc");
+
+    Dict dict;
+    REQUIRE_BARRIER(dict_from_trie(&dict, &root, SCORES) == 0);
+    trie_free(&root);
+
+    const uint32_t a = dict_step(&dict, 0, 'a');
+    REQUIRE_BARRIER(a != DICT_NONE);
+    REQUIRE(dict_is_word(&dict, a));
+    REQUIRE(dict_has_children(&dict, a));
+
+    const uint32_t ab = dict_step(&dict, a, 'b');
+    REQUIRE_BARRIER(ab != DICT_NONE);
+    REQUIRE(dict_is_word(&dict, ab));
+    REQUIRE(!dict_has_children(&dict, ab));
+    REQUIRE(dict_step(&dict, ab, 'c') == DICT_NONE);
+
+    const uint32_t b = dict_step(&dict, 0, 'b');
+    REQUIRE_BARRIER(b != DICT_NONE);
+    REQUIRE(!dict_is_word(&dict, b));
+    REQUIRE(dict_has_children(&dict, b));
+    REQUIRE(dict_step(&dict, b, 'b') == DICT_NONE);
+    REQUIRE(dict_step(&dict, 0, 'c') == DICT_NONE);
+    REQUIRE(dict_step(&dict, 0, ' ') == DICT_NONE);
+
+    dict_free(&dict);
+  }
+
+  /* check that nodes shared between parents only have their children stored once */
+  SUBTEST("flatten dawg") {
+    const char *words[4] = {"ab", "abc", "bb", "bbc"};
+
+    Trie root;
+    REQUIRE_BARRIER(trie_init_dawg(&root, words, 4) == 0);
+
+    Dict dict;
+    REQUIRE_BARRIER(dict_from_trie(&dict, &root, SCORES) == 0);
+    trie_destroy(&root);
+
+    // This should create the following array:
+    //   0: ROOT -> 1, 2
+    //   1: a    -> 3
+    //   2: b    -> 4
+    //   3: b    -> 5
+    //   4: b    -> 5
+    //   5: c
+    REQUIRE_BARRIER(dict.num_nodes == 6);
+    REQUIRE(dict.nodes[3].first == dict.nodes[4].first);
+    REQUIRE(dict.nodes[3].mask == dict.nodes[4].mask);
+    REQUIRE(dict.nodes[5].mask == DICT_TERMINAL);
+
+    for (int i = 0; i < 4; i++) {
+      REQUIRE(dict_contains(&dict, words[i], 0));
+    }
+    REQUIRE(!dict_contains(&dict, "a", 0));
+    REQUIRE(!dict_contains(&dict, "abcc", 1));
+
+    /* the shared node is summarised the same way from both parents */
+    const uint32_t bit_b = 1u << TRIE_IDX('b');
+    const uint32_t bit_c = 1u << TRIE_IDX('c');
+    REQUIRE(dict_reachable_letters(&dict, 0) == (bit_b | bit_c | (1u << TRIE_IDX('a'))));
+    REQUIRE(dict_min_remaining(&dict, 0) == 2);
+    REQUIRE(dict_reachable_letters(&dict, 1) == (bit_b | bit_c));
+    REQUIRE(dict_min_remaining(&dict, 1) == 1);
+    REQUIRE(dict_reachable_letters(&dict, 3) == bit_c);
+    REQUIRE(dict_reachable_letters(&dict, 4) == bit_c);
+    REQUIRE(dict_min_remaining(&dict, 4) == 1);
+
+    /* longer words are needed when the prefix is not a word itself */
+    const char *long_words[2] = {"abcde", "abcdefg"};
+    Trie long_root;
+    REQUIRE_BARRIER(trie_init_dawg(&long_root, long_words, 2) == 0);
+    Dict long_dict;
+    REQUIRE_BARRIER(dict_from_trie(&long_dict, &long_root, SCORES) == 0);
+    trie_destroy(&long_root);
+    REQUIRE(dict_min_remaining(&long_dict, 0) == 5);
+    REQUIRE(dict_min_remaining(&long_dict, dict_step(&long_dict, 0, 'a')) == 4);
+    dict_free(&long_dict);
+
+    /* score bounds that are too big to store are clamped */
+    const char *zzz[1] = {"zzzzzzzzzzzzzzzzzzzzzzzzzzzzzz"};
+    REQUIRE_BARRIER(trie_init_dawg(&long_root, zzz, 1) == 0);
+    REQUIRE_BARRIER(dict_from_trie(&long_dict, &long_root, SCORES) == 0);
+    trie_destroy(&long_root);
+    REQUIRE(dict_max_score(&long_dict, 0) == DICT_MAX_SCORE);
+    REQUIRE(dict_max_score(&long_dict, dict_step(&long_dict, 0, 'z')) == DICT_MAX_SCORE);
+    dict_free(&long_dict);
+
+    dict_free(&dict);
+  }
+
+  /* check that the words are listed in alphabetical order, up to a length */
+  SUBTEST("list words") {
+    const char *words[5] = {"a", "ab", "abcd", "b", "bc"};
+
+    Trie root;
+    REQUIRE_BARRIER(trie_init_dawg(&root, words, 5) == 0);
+    Dict dict;
+    REQUIRE_BARRIER(dict_from_trie(&dict, &root, SCORES) == 0);
+    trie_destroy(&root);
+
+    char *list;
+    uint32_t num_words;
+    REQUIRE_BARRIER(dict_list_words(&dict, 3, &list, &num_words) == 0);
+    REQUIRE_BARRIER(num_words == 4);
+    REQUIRE(strcmp(list + 0, "a") == 0);
+    REQUIRE(strcmp(list + 4, "ab") == 0);
+    REQUIRE(strcmp(list + 8, "b") == 0);
+    REQUIRE(strcmp(list + 12, "bc") == 0);
+
+    free(list);
+    dict_free(&dict);
+  }
+
+  /* check that dictionaries survive a round trip through a file */
+  SUBTEST("file") {
+    const char *path = "test_dict.tmp";
+
+    Trie root = trie_root();
+    trie_insert(&root, "a");
+    trie_insert(&root, "aa");
+    trie_insert(&root, "ab");
+    trie_insert(&root, "bc");
+
+    Dict dict;
+    REQUIRE_BARRIER(dict_from_trie(&dict, &root, SCORES) == 0);
+    trie_free(&root);
+    REQUIRE_BARRIER(dict_write(&dict, path) == 0);
+
+    Dict mapped;
+    REQUIRE_BARRIER(dict_open(&mapped, path) == 0);
+    REQUIRE(mapped.map != NULL);
+    REQUIRE(mapped.storage == NULL);
+    REQUIRE_BARRIER(mapped.num_nodes == dict.num_nodes);
+    REQUIRE(memcmp(mapped.nodes, dict.nodes, dict.num_nodes * sizeof(DictNode)) == 0);
+    REQUIRE(dict_contains(&mapped, "ab", 0));
+    REQUIRE(!dict_contains(&mapped, "b", 0));
+    REQUIRE(dict_contains(&mapped, "b", 1));
+    dict_free(&mapped);
+    REQUIRE(mapped.map == NULL);
+
+    /* missing files */
+    REQUIRE(dict_open(&mapped, "test_dict.missing") == 1);
+
+    /* corrupt the last node */
+    FILE *fp = fopen(path, "r+b");
+    REQUIRE_BARRIER(fp);
+    fseek(fp, -1, SEEK_END);
+    fputc(0xFF, fp);
+    fclose(fp);
+    REQUIRE(dict_open(&mapped, path) == 3);
+
+    /* break the header */
+    fp = fopen(path, "r+b");
+    REQUIRE_BARRIER(fp);
+    fputc('X', fp);
+    fclose(fp);
+    REQUIRE(dict_open(&mapped, path) == 2);
+
+    remove(path);
+    dict_free(&dict);
+  }
+
+  END_TEST();
+}
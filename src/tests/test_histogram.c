@@ -0,0 +1,130 @@
+#include "testing.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "src/core/dict.h"
+#include "src/core/game_tileset.h"
+#include "src/core/histogram.h"
+#include "src/core/trie.h"
+
+
+static const char SCORES[26] = LETTER_SCORES;
+
+
+/**
+ * Count the letters of a rack.
+ *
+ * @param letters the letters in the rack (not including blanks)
+ * @param rack set to the number of each letter
+ */
+static void count_rack(const char *letters, uint8_t rack[HISTOGRAM_WIDTH]) {
+  memset(rack, 0, HISTOGRAM_WIDTH);
+  for (int i = 0; letters[i] != '\0'; i++) {
+    rack[letters[i] - 'a']++;
+  }
+}
+
+
+int main(void) {
+  START_TEST("histogram");
+
+  /* check that every word is counted */
+  SUBTEST("records") {
+    const char *words[4] = {"bee", "cab", "toolong", "zoo"};
+
+    Trie root;
+    REQUIRE_BARRIER(trie_init_dawg(&root, words, 4) == 0);
+    Dict dict;
+    REQUIRE_BARRIER(dict_from_trie(&dict, &root, SCORES) == 0);
+    trie_destroy(&root);
+
+    Histogram histogram;
+    REQUIRE_BARRIER(histogram_from_dict(&histogram, &dict, 3) == 0);
+    REQUIRE_BARRIER(histogram.num_words == 3);
+    REQUIRE((uintptr_t) histogram.records % HISTOGRAM_WIDTH == 0);
+
+    REQUIRE(strcmp(histogram.words, "bee") == 0);
+    REQUIRE(histogram.records[1] == 1);
+    REQUIRE(histogram.records[4] == 2);
+    REQUIRE(strcmp(histogram.words + 8, "zoo") == 0);
+    REQUIRE(histogram.records[2 * HISTOGRAM_WIDTH + 14] == 2);
+    REQUIRE(histogram.records[2 * HISTOGRAM_WIDTH + 25] == 1);
+
+    int total = 0;
+    for (int i = 0; i < 3 * HISTOGRAM_WIDTH; i++) {
+      total += histogram.records[i];
+    }
+    REQUIRE(total == 9); // nothing in the padding
+
+    histogram_free(&histogram);
+    REQUIRE(histogram.records == NULL);
+    REQUIRE(histogram_from_dict(&histogram, &dict, 0) == 1);
+
+    dict_free(&dict);
+  }
+
+  /* check that every backend finds the same words */
+  SUBTEST("match") {
+    const char *words[8] = {"a", "bee", "cab", "ebb", "ee", "zoo", "zooz", "zzzzzzzzzzzzzzzzzzzz"};
+
+    Trie root;
+    REQUIRE_BARRIER(trie_init_dawg(&root, words, 8) == 0);
+    Dict dict;
+    REQUIRE_BARRIER(dict_from_trie(&dict, &root, SCORES) == 0);
+    trie_destroy(&root);
+
+    Histogram histogram;
+    REQUIRE_BARRIER(histogram_from_dict(&histogram, &dict, 20) == 0);
+    REQUIRE_BARRIER(histogram.num_words == 8);
+
+    REQUIRE(histogram_supports(HISTOGRAM_AUTO));
+    REQUIRE(histogram_supports(HISTOGRAM_SCALAR));
+    REQUIRE(!histogram_supports((HistogramBackend) -1));
+
+    const HistogramBackend backends[4] = {HISTOGRAM_AUTO, HISTOGRAM_SCALAR, HISTOGRAM_SSE2, HISTOGRAM_AVX2};
+    for (int b = 0; b < 4; b++) {
+      if (!histogram_supports(backends[b])) {
+        continue;
+      }
+
+      uint8_t rack[HISTOGRAM_WIDTH];
+      uint32_t matches[8];
+
+      /* exact letters only */
+      count_rack("abce", rack);
+      REQUIRE_BARRIER(histogram_match(&histogram, backends[b], rack, 0, 0, 8, matches) == 2);
+      REQUIRE(matches[0] == 0); // a
+      REQUIRE(matches[1] == 2); // cab
+
+      /* blanks make up for missing letters */
+      REQUIRE_BARRIER(histogram_match(&histogram, backends[b], rack, 1, 0, 8, matches) == 5);
+      REQUIRE(matches[1] == 1); // bee
+      REQUIRE(matches[3] == 3); // ebb
+      REQUIRE(matches[4] == 4); // ee
+      REQUIRE(histogram_match(&histogram, backends[b], rack, 2, 0, 8, matches) == 5);
+
+      /* only part of the index */
+      REQUIRE_BARRIER(histogram_match(&histogram, backends[b], rack, 1, 2, 4, matches) == 2);
+      REQUIRE(matches[0] == 2);
+      REQUIRE(matches[1] == 3);
+
+      /* counts past the first 16 letters, and large deficits */
+      count_rack("oz", rack);
+      REQUIRE(histogram_match(&histogram, backends[b], rack, 0, 0, 8, matches) == 0);
+      REQUIRE_BARRIER(histogram_match(&histogram, backends[b], rack, 2, 0, 8, matches) == 4);
+      REQUIRE(matches[0] == 0); // a
+      REQUIRE(matches[1] == 4); // ee
+      REQUIRE(matches[2] == 5); // zoo
+      REQUIRE(matches[3] == 6); // zooz
+      count_rack("z", rack);
+      REQUIRE(histogram_match(&histogram, backends[b], rack, 19, 7, 8, matches) == 1);
+      REQUIRE(histogram_match(&histogram, backends[b], rack, 18, 7, 8, matches) == 0);
+    }
+
+    histogram_free(&histogram);
+    dict_free(&dict);
+  }
+
+  END_TEST();
+}
@@ -0,0 +1,112 @@
+#include "testing.h"
+
+#include <string.h>
+
+#include "src/core/louds.h"
+#include "src/core/trie.h"
+#include "src/wordlists/en-gb.h"
+
+
+int main(void) {
+  START_TEST("louds");
+
+  /* check stepping between nodes works as expected */
+  SUBTEST("step") {
+    Trie root = trie_root();
+    trie_insert(&root, "a");
+    trie_insert(&root, "aa");
+    trie_insert(&root, "ab");
+    trie_insert(&root, "bc");
+
+    Louds louds;
+    REQUIRE_BARRIER(louds_from_trie(&louds, &root) == 0);
+    trie_free(&root);
+
+    // This should number the nodes as follows:
+    //   0: ROOT -> 1, 2
+    //   1: a    -> 3, 4
+    //   2: b    -> 5
+    //   3: a
+    //   4: b
+    //   5: c
+    REQUIRE_BARRIER(louds.num_nodes == 6);
+    REQUIRE(louds_step(&louds, 0, 'a') == 1);
+    REQUIRE(louds_step(&louds, 0, 'b') == 2);
+    REQUIRE(louds_step(&louds, 0, 'c') == LOUDS_NONE);
+    REQUIRE(louds_step(&louds, 1, 'a') == 3);
+    REQUIRE(louds_step(&louds, 1, 'b') == 4);
+    REQUIRE(louds_step(&louds, 2, 'a') == LOUDS_NONE);
+    REQUIRE(louds_step(&louds, 2, 'c') == 5);
+    REQUIRE(louds_step(&louds, 3, 'a') == LOUDS_NONE);
+    REQUIRE(louds_step(&louds, 5, 'z') == LOUDS_NONE);
+
+    const int is_word[6] = {0, 1, 0, 1, 1, 1};
+    const int has_children[6] = {1, 1, 1, 0, 0, 0};
+    for (uint32_t i = 0; i < 6; i++) {
+      REQUIRE(louds_is_word(&louds, i) == is_word[i]);
+      REQUIRE(louds_has_children(&louds, i) == has_children[i]);
+    }
+
+    louds_free(&louds);
+    REQUIRE(louds.bits == NULL);
+  }
+
+  /* check contains works as expected */
+  SUBTEST("contains") {
+    Trie root = trie_root();
+    trie_insert(&root, "a");
+    trie_insert(&root, "aa");
+    trie_insert(&root, "ab");
+    trie_insert(&root, "bc");
+
+    Louds louds;
+    REQUIRE_BARRIER(louds_from_trie(&louds, &root) == 0);
+    trie_free(&root);
+
+    REQUIRE(louds_contains(&louds, "a", 0));
+    REQUIRE(louds_contains(&louds, "aa", 0));
+    REQUIRE(louds_contains(&louds, "ab", 0));
+    REQUIRE(louds_contains(&louds, "bc", 0));
+
+    REQUIRE(!louds_contains(&louds, "b", 0));
+    REQUIRE(louds_contains(&louds, "b", 1));
+
+    REQUIRE(!louds_contains(&louds, "c", 1));
+    REQUIRE(!louds_contains(&louds, "zab", 1));
+    REQUIRE(!louds_contains(&louds, "aab", 1));
+    REQUIRE(!louds_contains(&louds, "A", 1));
+
+    louds_free(&louds);
+  }
+
+  /* check that the full dictionary (expanded from a DAWG) is encoded correctly */
+  SUBTEST("dictionary") {
+    Trie root;
+    REQUIRE_BARRIER(trie_init_dawg(&root, EN_GB, NUM_EN_GB) == 0);
+
+    Louds louds;
+    REQUIRE_BARRIER(louds_from_trie(&louds, &root) == 0);
+
+    /* every word is present, but the prefixes formed by dropping the last letter only match as prefixes */
+    for (int i = 0; i < NUM_EN_GB; i++) {
+      REQUIRE(louds_contains(&louds, EN_GB[i], 0));
+
+      char prefix[32];
+      const size_t len = strlen(EN_GB[i]);
+      memcpy(prefix, EN_GB[i], len - 1);
+      prefix[len - 1] = '\0';
+      REQUIRE(louds_contains(&louds, prefix, 1));
+      REQUIRE(louds_contains(&louds, prefix, 0) == trie_contains(&root, prefix, 0));
+    }
+    REQUIRE(!louds_contains(&louds, "aardvarkz", 1));
+    REQUIRE(!louds_contains(&louds, "qqq", 1));
+
+    /* a handful of bits per node */
+    REQUIRE(8 * louds_size(&louds) < 10 * (size_t) louds.num_nodes);
+
+    louds_free(&louds);
+    trie_destroy(&root);
+  }
+
+  END_TEST();
+}
@@ -0,0 +1,171 @@
+#include "testing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/core/dict.h"
+#include "src/core/game_tileset.h"
+#include "src/core/table.h"
+
+
+#define NUM_SOLVED (300) // number of racks solved for the test table
+
+
+/**
+ * Lay out the tiles of a rack.
+ *
+ * @param counts the number of each tile in the rack
+ * @param game the game state to put the tiles in
+ */
+static void set_rack(const int counts[TABLE_SYMBOLS], struct Game *game) {
+  memset(game, 0, sizeof(struct Game));
+  int n = 0;
+  for (int symbol = 0; symbol < TABLE_SYMBOLS; symbol++) {
+    for (int c = 0; c < counts[symbol]; c++) {
+      game->letters[n++] = symbol == 26 ? BLANK : (char) ('a' + symbol);
+    }
+  }
+}
+
+
+/**
+ * Compare two words of a table.
+ *
+ * @param a pointer to the first word
+ * @param b pointer to the second word
+ * @return the order of the words, as for strcmp
+ */
+static int compare_words(const void *a, const void *b) {
+  return strncmp(a, b, SIZE + 1);
+}
+
+
+int main(void) {
+  START_TEST("table");
+
+  /* check that every rack has its own rank */
+  SUBTEST("rank") {
+    REQUIRE(table_num_racks() == 4272048); // 33 choose 7
+
+    int counts[TABLE_SYMBOLS] = {0};
+    counts[0] = SIZE;
+    REQUIRE(table_rank(counts) == 0);
+    counts[0] = 0;
+    counts[26] = SIZE;
+    REQUIRE(table_rank(counts) == table_num_racks() - 1);
+
+    int bad = 0;
+    for (uint32_t rank = 0; rank < table_num_racks(); rank++) {
+      table_unrank(rank, counts);
+
+      int total = 0;
+      for (int symbol = 0; symbol < TABLE_SYMBOLS; symbol++) {
+        total += counts[symbol];
+      }
+      bad += total != SIZE || table_rank(counts) != rank;
+    }
+    REQUIRE(bad == 0);
+  }
+
+  /* check that a table gives the same best words as searching */
+  SUBTEST("lookup") {
+    const char *path = "test_table.tmp";
+    const Dict *dict = dictionary_tileset();
+    REQUIRE_BARRIER(dict);
+
+    char *words;
+    uint32_t num_words;
+    REQUIRE_BARRIER(dict_list_words(dict, SIZE, &words, &num_words) == 0);
+
+    /* solve the first few racks, leaving the rest unsolved */
+    const size_t num_entries = (size_t) table_num_racks() * STORE;
+    uint32_t *entries = malloc(num_entries * sizeof(uint32_t));
+    REQUIRE_BARRIER(entries);
+    for (size_t i = 0; i < num_entries; i++) {
+      entries[i] = TABLE_UNSOLVED;
+    }
+
+    struct Game game;
+    int counts[TABLE_SYMBOLS];
+    for (uint32_t rank = 0; rank < NUM_SOLVED; rank++) {
+      table_unrank(rank, counts);
+      set_rack(counts, &game);
+      search_top_words_tileset(&game);
+
+      for (int i = 0; i < STORE; i++) {
+        uint32_t index = TABLE_NO_WORD;
+        if (game.top_words[i][0]) {
+          const char *word = bsearch(game.top_words[i], words, num_words, SIZE + 1, compare_words);
+          REQUIRE_BARRIER(word);
+          index = (uint32_t) (word - words) / (SIZE + 1);
+        }
+        entries[(size_t) rank * STORE + i] = TABLE_ENTRY(index, game.top_scores[i]);
+      }
+    }
+    REQUIRE_BARRIER(table_write(path, dict_checksum(dict), words, num_words, entries) == 0);
+
+    Table table;
+    REQUIRE_BARRIER(table_open(&table, path, dict_checksum(dict)) == 0);
+    REQUIRE(table.num_words == num_words);
+    REQUIRE(table.num_racks == table_num_racks());
+
+    char top_words[STORE][SIZE + 1];
+    int top_scores[STORE];
+    int bad = 0;
+    for (uint32_t rank = 0; rank < NUM_SOLVED; rank++) {
+      table_unrank(rank, counts);
+      set_rack(counts, &game);
+      search_top_words_tileset(&game);
+
+      REQUIRE_BARRIER(table_lookup(&table, counts, top_words, top_scores));
+      for (int i = 0; i < STORE; i++) {
+        bad += strcmp(top_words[i], game.top_words[i]) != 0 || top_scores[i] != game.top_scores[i];
+      }
+    }
+    REQUIRE(bad == 0);
+
+    /* racks that were not solved have to be searched for */
+    table_unrank(NUM_SOLVED, counts);
+    REQUIRE(!table_lookup(&table, counts, top_words, top_scores));
+    table_free(&table);
+    REQUIRE(table.map == NULL);
+
+    /* the game uses the table before searching */
+    REQUIRE_BARRIER(open_table_tileset(path) == 0);
+    clear_cache_tileset();
+    table_unrank(1, counts);
+    set_rack(counts, &game);
+    top_words_tileset(&game);
+    table_unrank(NUM_SOLVED, counts);
+    set_rack(counts, &game);
+    top_words_tileset(&game);
+    int hits, misses;
+    stats_cache_tileset(&hits, &misses);
+    REQUIRE(hits == 0);
+    REQUIRE(misses == 1); // only the unsolved rack got as far as the cache
+    free_table_tileset();
+    clear_cache_tileset();
+
+    /* missing files */
+    REQUIRE(table_open(&table, "test_table.missing", dict_checksum(dict)) == 1);
+
+    /* tables made with a different dictionary */
+    REQUIRE(table_open(&table, path, dict_checksum(dict) + 1) == 2);
+
+    /* incomplete files */
+    FILE *fp = fopen(path, "ab");
+    REQUIRE_BARRIER(fp);
+    fputc('X', fp);
+    fclose(fp);
+    REQUIRE(table_open(&table, path, dict_checksum(dict)) == 3);
+
+    remove(path);
+    free(entries);
+    free(words);
+  }
+
+  free_dictionary_tileset();
+
+  END_TEST();
+}
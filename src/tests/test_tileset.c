@@ -1,8 +1,11 @@
 #include "testing.h"
 
+#include <stdio.h>
 #include <string.h>
 
 #include "src/core/game_tileset.h"
+#include "src/core/trie.h"
+#include "src/wordlists/en-gb.h"
 
 
 int main(void) {
@@ -114,6 +117,47 @@ int main(void) {
     REQUIRE(score_word_tileset(&game, "bqz") == 3); // valid letter combination using both blanks
   }
 
+  /* check that every word in the word list that fits in a rack (and nothing else) is valid */
+  SUBTEST("is word") {
+    int missing = 0;
+    int too_long = 0;
+    for (int i = 0; i < NUM_EN_GB; i++) {
+      if (strlen(EN_GB[i]) <= SIZE) {
+        missing += !is_rack_word_tileset(EN_GB[i]);
+      } else {
+        too_long += is_rack_word_tileset(EN_GB[i]); // valid words, but they can never be made from a rack
+      }
+    }
+    REQUIRE(missing == 0);
+    REQUIRE(too_long == 0);
+
+    REQUIRE(!is_rack_word_tileset(""));
+    REQUIRE(!is_rack_word_tileset("abd"));
+    REQUIRE(!is_rack_word_tileset("Bed"));
+    REQUIRE(!is_rack_word_tileset("be d"));
+    REQUIRE(!is_rack_word_tileset("qqq"));
+    REQUIRE(is_rack_word_tileset("bed"));
+
+    /* dictionary files keep words too long for a rack, but these still can never be made */
+    const char *path = "test_tileset_dict.tmp";
+    const char scores[26] = LETTER_SCORES;
+    Trie root = trie_root();
+    trie_insert(&root, "bed");
+    trie_insert(&root, "bedstead");
+    Dict dict;
+    REQUIRE_BARRIER(dict_from_trie(&dict, &root, scores) == 0);
+    trie_free(&root);
+    REQUIRE_BARRIER(dict_write(&dict, path) == 0);
+    dict_free(&dict);
+
+    REQUIRE_BARRIER(open_dictionary_tileset(path) == 0);
+    REQUIRE(dict_contains(dictionary_tileset(), "bedstead", 0));
+    REQUIRE(is_rack_word_tileset("bed"));
+    REQUIRE(!is_rack_word_tileset("bedstead"));
+    free_dictionary_tileset();
+    remove(path);
+  }
+
   /* check that words are submitted correctly */
   SUBTEST("submit word") {
     struct Game game;
@@ -142,6 +186,30 @@ int main(void) {
     REQUIRE(submit_word_tileset(&game, "abd") == 0); // valid letters, not a word
     REQUIRE(submit_word_tileset(&game, "gaze") == 2); // real word, valid letters (using two blanks)
     REQUIRE(submit_word_tileset(&game, "quad") == 3); // real word, valid letters (using two blanks)
+
+    /* not lowercase letters */
+    REQUIRE(submit_word_tileset(&game, "BED") == 0);
+    REQUIRE(submit_word_tileset(&game, "be d") == 0);
+  }
+
+  /* check that the dictionary can be reloaded after it has been freed */
+  SUBTEST("dictionary") {
+    struct Game game;
+    reset_tileset(&game, NULL, 0);
+    memcpy(game.letters, "abcdefg", 7);
+
+    REQUIRE(load_dictionary_tileset() == 0);
+    REQUIRE(load_dictionary_tileset() == 0); // already loaded
+    REQUIRE(submit_word_tileset(&game, "bed") == 6);
+
+    free_dictionary_tileset();
+    free_dictionary_tileset(); // already freed
+    REQUIRE(submit_word_tileset(&game, "bed") == 6); // reloaded on demand
+    REQUIRE(submit_word_tileset(&game, "abd") == 0);
+
+    /* missing dictionary files leave nothing loaded, so the built-in one is used */
+    REQUIRE(open_dictionary_tileset("test_tileset.missing") != 0);
+    REQUIRE(submit_word_tileset(&game, "bed") == 6);
   }
 
   SUBTEST("find blanks") {
@@ -226,5 +294,325 @@ int main(void) {
     }
   }
 
+  /* check that a blank is never used for a letter that there is still a real tile for */
+  SUBTEST("top words (blank scoring)") {
+    struct Game game;
+    reset_tileset(&game, NULL, 0);
+    memcpy(game.letters, "e cmiyt", 7);
+    top_words_tileset(&game);
+
+    REQUIRE(strcmp(game.top_words[0], "etymic") == 0);
+    REQUIRE(game.top_scores[0] == 13);
+  }
+
+  /* check that repeated letters only find each word once */
+  SUBTEST("top words (repeated letters)") {
+    struct Game game;
+    reset_tileset(&game, NULL, 0);
+    memcpy(game.letters, "eeeaaio", 7);
+    top_words_tileset(&game);
+
+    for (int i = 0; i < STORE; i++) {
+      REQUIRE(game.top_scores[i] == score_word_tileset(&game, game.top_words[i]));
+      for (int j = 0; j < i; j++) {
+        REQUIRE(strcmp(game.top_words[i], game.top_words[j]) != 0);
+      }
+    }
+  }
+
+  /* check that sharing the search between threads finds the same words in the same order */
+  SUBTEST("top words (threads)") {
+    const char *racks[4] = {"  eaist", "e cmiyt", "quitqqq", "eeeaaio"};
+    for (int r = 0; r < 4; r++) {
+      struct Game serial, parallel;
+      reset_tileset(&serial, NULL, 0);
+      memcpy(serial.letters, racks[r], 7);
+      parallel = serial;
+
+      REQUIRE(set_threads_tileset(1) == 1);
+      top_words_tileset(&serial);
+      REQUIRE(set_threads_tileset(4) == 4);
+      clear_cache_tileset();
+      top_words_tileset(&parallel);
+
+      for (int i = 0; i < STORE; i++) {
+        REQUIRE(strcmp(serial.top_words[i], parallel.top_words[i]) == 0);
+        REQUIRE(serial.top_scores[i] == parallel.top_scores[i]);
+      }
+    }
+
+    REQUIRE(set_threads_tileset(MAX_THREADS + 1) == MAX_THREADS);
+    REQUIRE(set_threads_tileset(0) >= 1);
+    set_threads_tileset(1);
+  }
+
+  /* check that every solver finds the same words in the same order */
+  SUBTEST("top words (solvers)") {
+    const char *racks[5] = {"  eaist", "e cmiyt", "quitqqq", "eeeaaio", "zzzzzzz"};
+    for (int r = 0; r < 5 + 100; r++) {
+      struct Game trie;
+      reset_tileset(&trie, NULL, 0); // random racks after the fixed ones
+      if (r < 5) {
+        memcpy(trie.letters, racks[r], 7);
+      }
+      REQUIRE_BARRIER(set_solver_tileset(SOLVER_TRIE) == 0);
+      search_top_words_tileset(&trie);
+
+      const Solver solvers[5] = {SOLVER_ANAGRAM, SOLVER_HISTOGRAM, SOLVER_HISTOGRAM, SOLVER_HISTOGRAM, SOLVER_HISTOGRAM};
+      const HistogramBackend backends[5] = {HISTOGRAM_AUTO, HISTOGRAM_AUTO, HISTOGRAM_SCALAR, HISTOGRAM_SSE2,
+                                            HISTOGRAM_AVX2};
+      for (int s = 0; s < 5; s++) {
+        if (set_histogram_backend_tileset(backends[s])) {
+          continue; // not supported by this CPU
+        }
+
+        struct Game other = trie;
+        memset(other.top_words, 0, sizeof(other.top_words));
+        memset(other.top_scores, 0, sizeof(other.top_scores));
+        REQUIRE_BARRIER(set_solver_tileset(solvers[s]) == 0);
+        search_top_words_tileset(&other);
+
+        for (int i = 0; i < STORE; i++) {
+          REQUIRE(strcmp(trie.top_words[i], other.top_words[i]) == 0);
+          REQUIRE(trie.top_scores[i] == other.top_scores[i]);
+        }
+      }
+    }
+
+    REQUIRE(set_solver_tileset((Solver) -1) == 1);
+    REQUIRE(set_histogram_backend_tileset(HISTOGRAM_SCALAR) == 0);
+    set_solver_tileset(SOLVER_TRIE);
+    set_histogram_backend_tileset(HISTOGRAM_AUTO);
+  }
+
+  /* check that a background search finds the same words */
+  SUBTEST("background search") {
+    struct Game game, expected;
+    reset_tileset(&game, NULL, 0);
+    memcpy(game.letters, "  eaist", 7);
+    expected = game;
+    top_words_tileset(&expected);
+
+    /* the game can still be played while the search runs */
+    clear_cache_tileset();
+    struct SolveTask *task = start_solve_tileset(&game);
+    REQUIRE_BARRIER(task != NULL);
+    REQUIRE(submit_word_tileset(&game, expected.top_words[STORE - 1]) > 0);
+    REQUIRE(submit_word_tileset(&game, "ableist") == 5);
+    REQUIRE(submit_word_tileset(&game, expected.top_words[1]) > 0);
+    REQUIRE(submit_word_tileset(&game, "ableist") == 5);
+    join_solve_tileset(task, &game);
+
+    for (int i = 0; i < STORE; i++) {
+      REQUIRE(strcmp(game.top_words[i], expected.top_words[i]) == 0);
+      REQUIRE(game.top_scores[i] == expected.top_scores[i]);
+    }
+    REQUIRE(strcmp(game.top_words[0], "ableist") == 0);
+
+    /* every best word submitted during the search is marked, not just the best one */
+    for (int i = 0; i < STORE; i++) {
+      REQUIRE(game.has_found[i] == (i == 0 || i == 1 || i == STORE - 1));
+    }
+
+    /* finished searches are reported as done, and searches can be abandoned part way through */
+    task = start_solve_tileset(&game);
+    REQUIRE_BARRIER(task != NULL);
+    while (!poll_solve_tileset(task)) {}
+    join_solve_tileset(task, &game);
+
+    task = start_solve_tileset(&game);
+    REQUIRE_BARRIER(task != NULL);
+    cancel_solve_tileset(task);
+  }
+
+  /* check that prefetched racks are reproducible and solved correctly */
+  SUBTEST("prefetch") {
+    struct Prefetch *first = start_prefetch_tileset(1234);
+    struct Prefetch *second = start_prefetch_tileset(1234);
+    REQUIRE_BARRIER(first != NULL && second != NULL);
+
+    for (int r = 0; r < 5; r++) {
+      struct Game game, other, expected;
+      struct SolveTask *task = next_rack_tileset(first, &game);
+      if (task) {
+        join_solve_tileset(task, &game);
+        resume_prefetch_tileset(first);
+      }
+      task = next_rack_tileset(second, &other); // left waiting after a miss, until the next rack is needed
+      if (task) {
+        cancel_solve_tileset(task);
+      }
+      REQUIRE(strcmp(game.letters, other.letters) == 0);
+
+      reset_tileset(&expected, NULL, 0);
+      memcpy(expected.letters, game.letters, SIZE);
+      clear_cache_tileset();
+      top_words_tileset(&expected);
+      for (int i = 0; i < STORE; i++) {
+        REQUIRE(strcmp(game.top_words[i], expected.top_words[i]) == 0);
+        REQUIRE(game.top_scores[i] == expected.top_scores[i]);
+        REQUIRE(game.has_found[i] == 0);
+      }
+      REQUIRE(game.score == 0);
+    }
+
+    int hits, misses;
+    stats_prefetch_tileset(first, &hits, &misses);
+    REQUIRE(hits + misses == 5);
+
+    /* a different seed gives different racks */
+    struct Prefetch *third = start_prefetch_tileset(4321);
+    REQUIRE_BARRIER(third != NULL);
+    int num_same = 0;
+    for (int r = 0; r < 5; r++) {
+      struct Game game, other;
+      struct SolveTask *task = next_rack_tileset(second, &game);
+      if (task) {
+        cancel_solve_tileset(task);
+      }
+      task = next_rack_tileset(third, &other);
+      if (task) {
+        cancel_solve_tileset(task);
+      }
+      num_same += strcmp(game.letters, other.letters) == 0;
+    }
+    REQUIRE(num_same < 5);
+
+    free_prefetch_tileset(first);
+    free_prefetch_tileset(second);
+    free_prefetch_tileset(third);
+  }
+
+  /* check that racks with the same letters are only searched once */
+  SUBTEST("cache") {
+    const char *path = "test_tileset_cache.tmp";
+    remove(path);
+    clear_cache_tileset();
+    REQUIRE_BARRIER(open_cache_tileset(path) == 0);
+
+    struct Game game, shuffled;
+    reset_tileset(&game, NULL, 0);
+    memcpy(game.letters, "quiet s", 7);
+    top_words_tileset(&game);
+    reset_tileset(&shuffled, NULL, 0);
+    memcpy(shuffled.letters, "s teiuq", 7);
+    top_words_tileset(&shuffled);
+
+    int hits, misses;
+    stats_cache_tileset(&hits, &misses);
+    REQUIRE(hits == 1);
+    REQUIRE(misses == 1);
+    for (int i = 0; i < STORE; i++) {
+      REQUIRE(strcmp(game.top_words[i], shuffled.top_words[i]) == 0);
+      REQUIRE(game.top_scores[i] == shuffled.top_scores[i]);
+    }
+
+    /* the file still has the rack after the in-memory cache is emptied */
+    clear_cache_tileset();
+    REQUIRE_BARRIER(open_cache_tileset(path) == 0);
+    reset_tileset(&shuffled, NULL, 0);
+    memcpy(shuffled.letters, "tuqies ", 7);
+    top_words_tileset(&shuffled);
+    stats_cache_tileset(&hits, &misses);
+    REQUIRE(hits == 1);
+    REQUIRE(misses == 0);
+    for (int i = 0; i < STORE; i++) {
+      REQUIRE(strcmp(game.top_words[i], shuffled.top_words[i]) == 0);
+      REQUIRE(game.top_scores[i] == shuffled.top_scores[i]);
+    }
+
+    /* the least recently used racks are dropped from memory once it is full */
+    clear_cache_tileset();
+    int num_racks = 0;
+    for (char a = 'a'; a <= 'z' && num_racks <= CACHE_SIZE; a++) {
+      for (char b = a; b <= 'z' && num_racks <= CACHE_SIZE; b++) {
+        for (char c = b; c <= 'z' && num_racks <= CACHE_SIZE; c++) {
+          reset_tileset(&shuffled, NULL, 0);
+          memcpy(shuffled.letters, "qqqq", 4);
+          shuffled.letters[4] = a;
+          shuffled.letters[5] = b;
+          shuffled.letters[6] = c;
+          top_words_tileset(&shuffled);
+          num_racks++;
+        }
+      }
+    }
+    stats_cache_tileset(&hits, &misses);
+    REQUIRE(hits == 0);
+    REQUIRE(misses == CACHE_SIZE + 1);
+
+    memcpy(shuffled.letters, "qqqqaab", 7); // the second rack is still there
+    top_words_tileset(&shuffled);
+    memcpy(shuffled.letters, "qqqqaaa", 7); // but the first is not
+    top_words_tileset(&shuffled);
+    stats_cache_tileset(&hits, &misses);
+    REQUIRE(hits == 1);
+    REQUIRE(misses == CACHE_SIZE + 2);
+
+    /* racks dropped from memory are read back from the file, rather than solved and appended again */
+    clear_cache_tileset();
+    REQUIRE_BARRIER(open_cache_tileset(path) == 0);
+    num_racks = 0;
+    for (char a = 'a'; a <= 'z' && num_racks <= CACHE_SIZE; a++) {
+      for (char b = a; b <= 'z' && num_racks <= CACHE_SIZE; b++) {
+        for (char c = b; c <= 'z' && num_racks <= CACHE_SIZE; c++) {
+          reset_tileset(&shuffled, NULL, 0);
+          memcpy(shuffled.letters, "qqqq", 4);
+          shuffled.letters[4] = a;
+          shuffled.letters[5] = b;
+          shuffled.letters[6] = c;
+          top_words_tileset(&shuffled);
+          num_racks++;
+        }
+      }
+    }
+    FILE *fp = fopen(path, "rb");
+    REQUIRE_BARRIER(fp);
+    fseek(fp, 0, SEEK_END);
+    const long file_size = ftell(fp);
+    fclose(fp);
+
+    stats_cache_tileset(&hits, &misses);
+    const int before_hits = hits, before_misses = misses;
+    memcpy(shuffled.letters, "qqqqaaa", 7); // evicted from memory, but still in the file
+    top_words_tileset(&shuffled);
+    stats_cache_tileset(&hits, &misses);
+    REQUIRE(hits == before_hits + 1);
+    REQUIRE(misses == before_misses);
+
+    /* more racks than fit in memory are all still there after reopening the file */
+    clear_cache_tileset();
+    REQUIRE_BARRIER(open_cache_tileset(path) == 0);
+    memcpy(shuffled.letters, "quiet s", 7); // the oldest racks are dropped from memory as the file is loaded
+    top_words_tileset(&shuffled);
+    memcpy(shuffled.letters, "qqqqaaa", 7);
+    top_words_tileset(&shuffled);
+    stats_cache_tileset(&hits, &misses);
+    REQUIRE(hits == 2);
+    REQUIRE(misses == 0);
+
+    fp = fopen(path, "rb");
+    REQUIRE_BARRIER(fp);
+    fseek(fp, 0, SEEK_END);
+    REQUIRE(ftell(fp) == file_size);
+    fclose(fp);
+
+    /* a damaged file is cut back to its last whole record */
+    fp = fopen(path, "ab");
+    REQUIRE_BARRIER(fp);
+    fputc('X', fp);
+    fclose(fp);
+    clear_cache_tileset();
+    REQUIRE(open_cache_tileset(path) == 0);
+    top_words_tileset(&game);
+    stats_cache_tileset(&hits, &misses);
+    REQUIRE(hits == 1);
+
+    clear_cache_tileset();
+    remove(path);
+  }
+
+  free_dictionary_tileset();
+
   END_TEST();
 }
@@ -33,6 +33,7 @@ int main(void) {
     REQUIRE(root.is_terminal == 0);
     REQUIRE(root.parent == NULL);
     REQUIRE(root.letter == '\0');
+    REQUIRE(root.arena == NULL);
 
     /* the first 'a' node should be terminal and have two children */
     Trie *a1 = root.children[TRIE_IDX('a')];
@@ -124,5 +125,112 @@ int main(void) {
     trie_free(&root);
   }
 
+  /* check that a trie can be followed one letter at a time */
+  SUBTEST("step") {
+    Trie root = trie_root();
+    trie_insert(&root, "a");
+    trie_insert(&root, "ab");
+    trie_insert(&root, "bc");
+
+    const Trie *a = trie_step(&root, 'a');
+    REQUIRE_BARRIER(a);
+    REQUIRE(a == root.children[TRIE_IDX('a')]);
+    REQUIRE(trie_is_word(a));
+    REQUIRE(trie_has_children(a));
+
+    const Trie *ab = trie_step(a, 'b');
+    REQUIRE_BARRIER(ab);
+    REQUIRE(trie_is_word(ab));
+    REQUIRE(!trie_has_children(ab));
+    REQUIRE(!trie_step(ab, 'c'));
+
+    const Trie *b = trie_step(&root, 'b');
+    REQUIRE_BARRIER(b);
+    REQUIRE(!trie_is_word(b));
+    REQUIRE(trie_has_children(b));
+    REQUIRE(!trie_step(b, 'b'));
+    REQUIRE(!trie_step(&root, 'c'));
+
+    trie_free(&root);
+  }
+
+  /* check that arena-backed tries behave like normal ones */
+  SUBTEST("arena") {
+    Trie root;
+    REQUIRE_BARRIER(trie_init_arena(&root) == 0);
+    REQUIRE(root.arena != NULL);
+    REQUIRE(root.is_terminal == 0);
+    REQUIRE(root.parent == NULL);
+    for (char c = 'a'; c <= 'z'; c++) {
+      REQUIRE(!root.children[TRIE_IDX(c)]);
+    }
+
+    /* insert enough words to need more than one slab */
+    char word[4] = {0};
+    for (char a = 'a'; a <= 'z'; a++) {
+      for (char b = 'a'; b <= 'z'; b++) {
+        for (char c = 'a'; c <= 'z'; c += 2) {
+          word[0] = a;
+          word[1] = b;
+          word[2] = c;
+          REQUIRE(trie_insert(&root, word) == 0);
+        }
+      }
+    }
+
+    REQUIRE(trie_contains(&root, "abc", 0));
+    REQUIRE(trie_contains(&root, "zzy", 0));
+    REQUIRE(!trie_contains(&root, "abd", 0));
+    REQUIRE(trie_contains(&root, "ab", 1));
+    REQUIRE(!trie_contains(&root, "ab", 0));
+    REQUIRE(root.children[TRIE_IDX('q')]->parent == &root);
+
+    /* destroying the trie leaves an empty root */
+    trie_destroy(&root);
+    REQUIRE(root.arena == NULL);
+    for (char c = 'a'; c <= 'z'; c++) {
+      REQUIRE(!root.children[TRIE_IDX(c)]);
+    }
+    REQUIRE(!trie_contains(&root, "a", 1));
+  }
+
+  /* check that a DAWG merges equivalent suffixes but holds the same words */
+  SUBTEST("dawg") {
+    const char *words[6] = {"cat", "cats", "dog", "dogs", "doing", "going"};
+
+    Trie root;
+    REQUIRE_BARRIER(trie_init_dawg(&root, words, 6) == 0);
+    REQUIRE(root.arena != NULL);
+
+    for (int i = 0; i < 6; i++) {
+      REQUIRE(trie_contains(&root, words[i], 0));
+    }
+    REQUIRE(trie_contains(&root, "doi", 1));
+    REQUIRE(!trie_contains(&root, "doi", 0));
+    REQUIRE(!trie_contains(&root, "ca", 0));
+    REQUIRE(!trie_contains(&root, "goings", 1));
+    REQUIRE(!trie_contains(&root, "cog", 1));
+
+    /* the final 's' of "cats" and "dogs" is shared */
+    const Trie *cat = root.children[TRIE_IDX('c')]->children[TRIE_IDX('a')]->children[TRIE_IDX('t')];
+    const Trie *dog = root.children[TRIE_IDX('d')]->children[TRIE_IDX('o')]->children[TRIE_IDX('g')];
+    REQUIRE(cat != dog); // different letters
+    REQUIRE(cat->children[TRIE_IDX('s')] == dog->children[TRIE_IDX('s')]);
+
+    /* as is the "ing" of "doing" and "going" (but not the "o", since only "do" is followed by "g") */
+    const Trie *doi = root.children[TRIE_IDX('d')]->children[TRIE_IDX('o')]->children[TRIE_IDX('i')];
+    const Trie *goi = root.children[TRIE_IDX('g')]->children[TRIE_IDX('o')]->children[TRIE_IDX('i')];
+    REQUIRE(doi == goi);
+    REQUIRE(root.children[TRIE_IDX('d')]->children[TRIE_IDX('o')] != root.children[TRIE_IDX('g')]->children[TRIE_IDX('o')]);
+
+    trie_destroy(&root);
+
+    /* the words must be sorted */
+    const char *unsorted[3] = {"b", "a", "c"};
+    REQUIRE(trie_init_dawg(&root, unsorted, 3) == 2);
+    const char *repeated[3] = {"a", "b", "b"};
+    REQUIRE(trie_init_dawg(&root, repeated, 3) == 2);
+  }
+
   END_TEST();
 }
@@ -1,3 +1,4 @@
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -27,6 +28,8 @@
 
 #define EMPTY (' ')
 
+#define SOLVE_POLL_MS (20) // how often to check for the best words while they are being found
+
 
 /**
  * User interface wrapper struct.
@@ -470,25 +473,61 @@ static void submit_word(struct UI *ui, struct Game *game) {
 }
 
 
+/**
+ * Get the seed for the racks that follow the first one.
+ *
+ * The seed is hashed from the letters of the first rack (FNV-1a), so a game started from a given seed always deals the
+ * same racks.
+ *
+ * @param letters The letters of the first rack.
+ * @return The seed for the prefetched racks.
+ */
+static unsigned int prefetch_seed(const char *letters) {
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < SIZE; i++) {
+    hash ^= (unsigned char) letters[i];
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+
 /**
  * Parse the command line arguments.
  *
  * @param argc The number of arguments.
  * @param argv The arguments.
  * @param seed Pointer to seed to use for the game.
+ * @param dict Pointer to the dictionary file to use (NULL for the built-in dictionary).
+ * @param threads Pointer to the number of threads to solve with (0 for one per CPU core).
+ * @param cache Pointer to the file to cache the best words in (NULL to only cache them in memory).
+ * @param table Pointer to the solution table file to look the best words up in (NULL to always search).
  * @return -1 for help text, 0 on success, non-zero on failure.
  */
-static int parse_args(const int argc, char *argv[], char **seed) {
+static int parse_args(const int argc, char *argv[], char **seed, char **dict, int *threads, char **cache,
+                      char **table) {
   static struct option long_options[] = {
     {"help", no_argument, 0, 'h'},
     {"seed", required_argument, 0, 's'},
+    {"dict", required_argument, 0, 'd'},
+    {"threads", required_argument, 0, 'j'},
+    {"cache", required_argument, 0, 'c'},
+    {"table", required_argument, 0, 't'},
     {0, 0, 0, 0}
   };
 
   const char *help_text = "TILESET: a word game\n"
       "  -h, --help      Display this help and exit\n"
       "  -s, --seed      Set the seed for the game.\n"
-      "                  The seed must be a 14-digit hex number.\n"
+      "                  The seed must be a 14-digit hex number, and also\n"
+      "                  sets the racks that follow.\n"
+      "  -d, --dict      Use a dictionary file instead of the built-in one.\n"
+      "  -j, --threads   Set the number of threads used to find the best\n"
+      "                  words (defaults to one per CPU core).\n"
+      "  -c, --cache     Keep the best words for each set of letters in a\n"
+      "                  file, so they are only found once.\n"
+      "  -t, --table     Look up the best words in a table made by mktable.\n"
       "\n"
       "  The aim of the game is to find as many of the top-10 best scoring\n"
       "  words as possible.\n";
@@ -497,7 +536,11 @@ static int parse_args(const int argc, char *argv[], char **seed) {
   int c, opt_index;
   int bad_option = 0;
   *seed = NULL;
-  while ((c = getopt_long(argc, argv, "hs:", long_options, &opt_index)) != -1) {
+  *dict = NULL;
+  *threads = 0;
+  *cache = NULL;
+  *table = NULL;
+  while ((c = getopt_long(argc, argv, "hs:d:j:c:t:", long_options, &opt_index)) != -1) {
     switch (c) {
       case 'h':
         fprintf(stderr, "%s", help_text);
@@ -505,6 +548,26 @@ static int parse_args(const int argc, char *argv[], char **seed) {
       case 's':
         *seed = optarg;
         break;
+      case 'd':
+        *dict = optarg;
+        break;
+      case 'c':
+        *cache = optarg;
+        break;
+      case 't':
+        *table = optarg;
+        break;
+      case 'j': {
+        char *endptr;
+        const long value = strtol(optarg, &endptr, 10);
+        if (endptr == optarg || *endptr != '\0' || value < 1 || value > MAX_THREADS) {
+          fprintf(stderr, "tileset: invalid number of threads: `%s'\n", optarg);
+          bad_option = 1;
+        } else {
+          *threads = (int) value;
+        }
+        break;
+      }
       case '?':
         bad_option = 1;
         break;
@@ -535,16 +598,43 @@ static int parse_args(const int argc, char *argv[], char **seed) {
 /**
  * Receive user input in a loop.
  *
+ * While the best words are still being found, input is polled so that they can be shown as soon as they are ready.
+ * The next rack is only prefetched once they have been (and likewise after each rack that was not prefetched in
+ * time), so that the two searches never compete for the same cores.
+ *
  * @param ui The user interface.
  * @param game The game state.
+ * @param task The background search for the best words (NULL if they are already known).
+ * @param seed The seed for the prefetched racks.
  */
-static void game_loop(struct UI *ui, struct Game *game) {
+static void game_loop(struct UI *ui, struct Game *game, struct SolveTask *task, const unsigned int seed) {
+  struct Prefetch *prefetch = NULL;
+  int is_prefetching = 0; // whether the prefetcher has been started (it may have failed to)
+
   /* render the screen before starting the game */
   ui_render(ui, game);
 
   /* game loop */
   while (1) {
+    /* get the next rack ready while this one is played (once no other search is using the threads) */
+    if (!task && !is_prefetching) {
+      prefetch = start_prefetch_tileset(seed);
+      is_prefetching = 1;
+    } else if (!task && prefetch) {
+      resume_prefetch_tileset(prefetch);
+    }
+
+    wtimeout(ui->win_input, task ? SOLVE_POLL_MS : -1);
     const int key = wgetch(ui->win_input);
+
+    /* fill in the best words once they have been found */
+    if (task && poll_solve_tileset(task)) {
+      join_solve_tileset(task, game);
+      task = NULL;
+      LOG("INFO: found top words");
+      ui_render(ui, game);
+    }
+
     if (key == ERR) {
       continue;
     }
@@ -565,7 +655,18 @@ static void game_loop(struct UI *ui, struct Game *game) {
         case 'R':
         case 'r':
           memset(ui->selected, 0, SIZE);
-          reset_tileset(game, NULL, 1);
+          if (task) {
+            cancel_solve_tileset(task);
+          }
+          if (prefetch) {
+            task = next_rack_tileset(prefetch, game);
+          } else {
+            reset_tileset(game, NULL, 0);
+            task = start_solve_tileset(game);
+            if (!task) {
+              top_words_tileset(game); // fall back to finding them now
+            }
+          }
           break;
         case 'S':
         case 's':
@@ -616,6 +717,16 @@ static void game_loop(struct UI *ui, struct Game *game) {
     ui_render(ui, game);
     ui->has_submitted = 0; // reset submition flag
   }
+
+  if (task) {
+    cancel_solve_tileset(task);
+  }
+  if (prefetch) {
+    int hits, misses;
+    stats_prefetch_tileset(prefetch, &hits, &misses);
+    LOG("INFO: prefetched racks: %d hits, %d misses", hits, misses);
+    free_prefetch_tileset(prefetch);
+  }
 }
 
 
@@ -625,17 +736,47 @@ int main(const int argc, char **argv) {
 
   /* parse the command line arguments */
   char *seed = NULL;
-  if (parse_args(argc, argv, &seed)) {
+  char *dict = NULL;
+  int threads = 0;
+  char *cache = NULL;
+  char *table = NULL;
+  if (parse_args(argc, argv, &seed, &dict, &threads, &cache, &table)) {
     return EXIT_FAILURE;
   }
+  set_threads_tileset(threads);
 
-  /* set up a tileset game state */
+  /* load the dictionary once, so that each reset only has to search it */
+  if (dict && open_dictionary_tileset(dict)) {
+    fprintf(stderr, "tileset: failed to open dictionary `%s'\n", dict);
+    return EXIT_FAILURE;
+  }
+  if (load_dictionary_tileset()) {
+    fprintf(stderr, "tileset: failed to load dictionary\n");
+    return EXIT_FAILURE;
+  }
+  if (cache && open_cache_tileset(cache)) {
+    fprintf(stderr, "tileset: failed to open cache `%s'\n", cache);
+    free_dictionary_tileset();
+    return EXIT_FAILURE;
+  }
+  if (table && open_table_tileset(table)) {
+    fprintf(stderr, "tileset: failed to open table `%s'\n", table);
+    free_dictionary_tileset();
+    return EXIT_FAILURE;
+  }
+
+  /* set up a tileset game state, finding the best words in the background */
   srand((unsigned int) time(NULL));
   struct Game game;
-  if (reset_tileset(&game, seed, 1)) {
+  if (reset_tileset(&game, seed, 0)) {
     fprintf(stderr, "tileset: bad seed `%s'\n", seed);
+    free_dictionary_tileset();
     return EXIT_FAILURE;
   }
+  struct SolveTask *task = start_solve_tileset(&game);
+  if (!task) {
+    top_words_tileset(&game);
+  }
 
   /* start up the TUI */
   tui_start();
@@ -645,17 +786,22 @@ int main(const int argc, char **argv) {
   if (ui_setup(&ui)) {
     LOG("ERROR: failed to set up UI");
     tui_end();
+    if (task) {
+      cancel_solve_tileset(task);
+    }
+    free_dictionary_tileset();
     return EXIT_FAILURE;
   }
 
   // use an unimportant plane for key handling
   tui_keypad(ui.win_input); // enable extra keyboard input (arrow keys etc.)
 
-  game_loop(&ui, &game);
+  game_loop(&ui, &game, task, seed ? prefetch_seed(game.letters) : (unsigned int) rand());
 
   /* clean up resources */
   ui_destroy(&ui);
   tui_end();
+  free_dictionary_tileset();
 
   return EXIT_SUCCESS;
 }
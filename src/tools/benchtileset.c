@@ -0,0 +1,522 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "src/core/dict.h"
+#include "src/core/game_tileset.h"
+#include "src/core/louds.h"
+#include "src/core/trie.h"
+
+
+/**
+ * A solver that can be benchmarked.
+ */
+struct Entry {
+  const char *name; // name used on the command line and in the results
+  Solver solver; // the solver
+  HistogramBackend backend; // how the histogram solver scans the words (ignored by the others)
+};
+
+
+// Every solver, with the first used as the reference for the others
+static const struct Entry SOLVERS[] = {
+  {"trie", SOLVER_TRIE, HISTOGRAM_AUTO},
+  {"anagram", SOLVER_ANAGRAM, HISTOGRAM_AUTO},
+  {"scalar", SOLVER_HISTOGRAM, HISTOGRAM_SCALAR},
+  {"sse2", SOLVER_HISTOGRAM, HISTOGRAM_SSE2},
+  {"avx2", SOLVER_HISTOGRAM, HISTOGRAM_AVX2},
+};
+
+#define NUM_SOLVERS ((int) (sizeof(SOLVERS) / sizeof(SOLVERS[0])))
+
+
+/**
+ * The same dictionary held in each of the ways it can be encoded.
+ */
+struct Encodings {
+  Trie trie; // pointer-based prefix tree
+  const Dict *dict; // flattened trie used to solve each game
+  Louds louds; // succinct trie
+};
+
+
+/**
+ * Running totals for a walk through the dictionary (see walk_trie).
+ */
+struct Walk {
+  long steps; // number of times a node was stepped to a child
+  long words; // number of words found (including repeats)
+};
+
+
+/**
+ * An encoding of the dictionary that can be benchmarked.
+ */
+struct Encoding {
+  const char *name; // name used on the command line and in the results
+  int (*contains)(struct Encodings *encodings, const char *word); // check if a word is in the dictionary
+  void (*walk)(struct Encodings *encodings, int counts[27], struct Walk *walk); // walk every word in a rack
+};
+
+
+/**
+ * Step through the trie to every word that can be made from a rack.
+ *
+ * Blanks are only used once a letter has run out, so each word is reached once for every node on the way to it.
+ *
+ * @param node The node reached so far.
+ * @param counts The number of each letter left in the rack, followed by the number of blanks.
+ * @param walk The running totals.
+ */
+static void walk_trie_node(const Trie *node, int counts[27], struct Walk *walk) {
+  for (int i = 0; i < 26; i++) {
+    const int tile = counts[i] ? i : 26;
+    if (!counts[tile]) {
+      continue;
+    }
+
+    walk->steps++;
+    const Trie *child = trie_step(node, (char) ('a' + i));
+    if (!child) {
+      continue;
+    }
+    walk->words += trie_is_word(child);
+    if (trie_has_children(child)) {
+      counts[tile]--;
+      walk_trie_node(child, counts, walk);
+      counts[tile]++;
+    }
+  }
+}
+
+
+/**
+ * Step through the dictionary to every word that can be made from a rack (see walk_trie_node).
+ *
+ * @param dict The dictionary.
+ * @param node The node reached so far.
+ * @param counts The number of each letter left in the rack, followed by the number of blanks.
+ * @param walk The running totals.
+ */
+static void walk_dict_node(const Dict *dict, const uint32_t node, int counts[27], struct Walk *walk) {
+  for (int i = 0; i < 26; i++) {
+    const int tile = counts[i] ? i : 26;
+    if (!counts[tile]) {
+      continue;
+    }
+
+    walk->steps++;
+    const uint32_t child = dict_step(dict, node, (char) ('a' + i));
+    if (child == DICT_NONE) {
+      continue;
+    }
+    walk->words += dict_is_word(dict, child);
+    if (dict_has_children(dict, child)) {
+      counts[tile]--;
+      walk_dict_node(dict, child, counts, walk);
+      counts[tile]++;
+    }
+  }
+}
+
+
+/**
+ * Step through the LOUDS trie to every word that can be made from a rack (see walk_trie_node).
+ *
+ * @param louds The LOUDS trie.
+ * @param node The node reached so far.
+ * @param counts The number of each letter left in the rack, followed by the number of blanks.
+ * @param walk The running totals.
+ */
+static void walk_louds_node(const Louds *louds, const uint32_t node, int counts[27], struct Walk *walk) {
+  for (int i = 0; i < 26; i++) {
+    const int tile = counts[i] ? i : 26;
+    if (!counts[tile]) {
+      continue;
+    }
+
+    walk->steps++;
+    const uint32_t child = louds_step(louds, node, (char) ('a' + i));
+    if (child == LOUDS_NONE) {
+      continue;
+    }
+    walk->words += louds_is_word(louds, child);
+    if (louds_has_children(louds, child)) {
+      counts[tile]--;
+      walk_louds_node(louds, child, counts, walk);
+      counts[tile]++;
+    }
+  }
+}
+
+
+/* wrappers giving each encoding the same interface */
+
+static int contains_trie(struct Encodings *encodings, const char *word) {
+  return trie_contains(&encodings->trie, word, 0);
+}
+
+static int contains_dict(struct Encodings *encodings, const char *word) {
+  return dict_contains(encodings->dict, word, 0);
+}
+
+static int contains_louds(struct Encodings *encodings, const char *word) {
+  return louds_contains(&encodings->louds, word, 0);
+}
+
+static void walk_trie(struct Encodings *encodings, int counts[27], struct Walk *walk) {
+  walk_trie_node(&encodings->trie, counts, walk);
+}
+
+static void walk_dict(struct Encodings *encodings, int counts[27], struct Walk *walk) {
+  walk_dict_node(encodings->dict, 0, counts, walk);
+}
+
+static void walk_louds(struct Encodings *encodings, int counts[27], struct Walk *walk) {
+  walk_louds_node(&encodings->louds, 0, counts, walk);
+}
+
+
+// Every encoding, with the first used as the reference for the others
+static const struct Encoding ENCODINGS[] = {
+  {"trie", contains_trie, walk_trie},
+  {"dict", contains_dict, walk_dict},
+  {"louds", contains_louds, walk_louds},
+};
+
+#define NUM_ENCODINGS ((int) (sizeof(ENCODINGS) / sizeof(ENCODINGS[0])))
+
+
+/**
+ * Parse the command line arguments.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @param num_racks Pointer to the number of racks to solve.
+ * @param seed Pointer to the seed used to draw the racks.
+ * @param selected Set to whether each solver should be benchmarked.
+ * @param selected_encodings Set to whether each encoding should be benchmarked.
+ * @return -1 for help text, 0 on success, non-zero on failure.
+ */
+static int parse_args(const int argc, char *argv[], int *num_racks, unsigned int *seed, int selected[NUM_SOLVERS],
+                      int selected_encodings[NUM_ENCODINGS]) {
+  static struct option long_options[] = {
+    {"help", no_argument, 0, 'h'},
+    {"racks", required_argument, 0, 'n'},
+    {"seed", required_argument, 0, 's'},
+    {"solver", required_argument, 0, 'S'},
+    {"encoding", required_argument, 0, 'e'},
+    {0, 0, 0, 0}
+  };
+
+  const char *help_text = "BENCHTILESET: time each way of finding the best words in a rack\n"
+      "  usage: benchtileset [options]\n"
+      "\n"
+      "  -h, --help      Display this help and exit\n"
+      "  -n, --racks     Set the number of racks to solve (defaults to 1000)\n"
+      "  -s, --seed      Set the seed used to draw the racks\n"
+      "  -S, --solver    Only time the named solver (can be repeated)\n"
+      "  -e, --encoding  Only time the named dictionary encoding (trie, dict\n"
+      "                  or louds, can be repeated)\n"
+      "\n"
+      "  Every solver is given the same racks, and any racks where a solver\n"
+      "  disagrees with the first one are counted as mismatches.\n"
+      "\n"
+      "  Each encoding looks up every word in the dictionary (along with a\n"
+      "  near miss for each), and steps to every word in each rack. Any counts\n"
+      "  that differ from the first encoding are reported as mismatches.\n";
+
+  /* parse arguments */
+  int c, opt_index;
+  int bad_option = 0;
+  int any_selected = 0;
+  *num_racks = 1000;
+  *seed = 1;
+  memset(selected, 0, NUM_SOLVERS * sizeof(int));
+  memset(selected_encodings, 0, NUM_ENCODINGS * sizeof(int));
+  while ((c = getopt_long(argc, argv, "hn:s:S:e:", long_options, &opt_index)) != -1) {
+    char *endptr;
+    long value;
+    switch (c) {
+      case 'h':
+        fprintf(stderr, "%s", help_text);
+        return -1;
+      case 'n':
+        value = strtol(optarg, &endptr, 10);
+        if (endptr == optarg || *endptr != '\0' || value < 1 || value > 10000000) {
+          fprintf(stderr, "benchtileset: invalid number of racks: `%s'\n", optarg);
+          bad_option = 1;
+        }
+        *num_racks = (int) value;
+        break;
+      case 's':
+        value = strtol(optarg, &endptr, 10);
+        if (endptr == optarg || *endptr != '\0') {
+          fprintf(stderr, "benchtileset: invalid seed: `%s'\n", optarg);
+          bad_option = 1;
+        }
+        *seed = (unsigned int) value;
+        break;
+      case 'S': {
+        int found = 0;
+        for (int i = 0; i < NUM_SOLVERS; i++) {
+          if (strcmp(optarg, SOLVERS[i].name) == 0) {
+            selected[i] = found = any_selected = 1;
+          }
+        }
+        if (!found) {
+          fprintf(stderr, "benchtileset: unknown solver: `%s'\n", optarg);
+          bad_option = 1;
+        }
+        break;
+      }
+      case 'e': {
+        int found = 0;
+        for (int i = 0; i < NUM_ENCODINGS; i++) {
+          if (strcmp(optarg, ENCODINGS[i].name) == 0) {
+            selected_encodings[i] = found = any_selected = 1;
+          }
+        }
+        if (!found) {
+          fprintf(stderr, "benchtileset: unknown encoding: `%s'\n", optarg);
+          bad_option = 1;
+        }
+        break;
+      }
+      case '?':
+        bad_option = 1;
+        break;
+      default:
+        break;
+    }
+  }
+
+  /* check for bad options */
+  if (bad_option || optind < argc) {
+    fprintf(stderr, "\n%s", help_text);
+    return 1;
+  }
+
+  /* time every solver and encoding unless told otherwise */
+  if (!any_selected) {
+    for (int i = 0; i < NUM_SOLVERS; i++) {
+      selected[i] = 1;
+    }
+    for (int i = 0; i < NUM_ENCODINGS; i++) {
+      selected_encodings[i] = 1;
+    }
+  }
+
+  return 0;
+}
+
+
+/**
+ * Get the time from a monotonic clock.
+ *
+ * @return the time in seconds
+ */
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + 1e-9 * (double) ts.tv_nsec;
+}
+
+
+/**
+ * Check if two games have the same best words.
+ *
+ * @param a the first game
+ * @param b the second game
+ * @return 1 if the words and scores match (in order), 0 otherwise
+ */
+static int same_words(const struct Game *a, const struct Game *b) {
+  for (int i = 0; i < STORE; i++) {
+    if (strcmp(a->top_words[i], b->top_words[i]) || a->top_scores[i] != b->top_scores[i]) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+
+/**
+ * Time looking up words in, and stepping through, each encoding of the dictionary.
+ *
+ * @param racks The racks to step through.
+ * @param num_racks The number of racks.
+ * @param selected Whether each encoding should be benchmarked.
+ * @return 0 on success, 1 on failure (due to failed malloc).
+ */
+static int bench_encodings(const struct Game *racks, const int num_racks, const int selected[NUM_ENCODINGS]) {
+  int any_selected = 0;
+  for (int i = 0; i < NUM_ENCODINGS; i++) {
+    any_selected |= selected[i];
+  }
+  if (!any_selected) {
+    return 0;
+  }
+
+  /* build every encoding from the words in the dictionary */
+  struct Encodings encodings;
+  encodings.dict = dictionary_tileset();
+  char *words;
+  uint32_t num_words;
+  if (!encodings.dict || dict_list_words(encodings.dict, SIZE, &words, &num_words)) {
+    return 1;
+  }
+  trie_init_arena(&encodings.trie); // falls back to allocating each node
+  int failed = 0;
+  for (uint32_t w = 0; w < num_words && !failed; w++) {
+    failed = trie_insert(&encodings.trie, words + w * (SIZE + 1));
+  }
+  if (failed || louds_from_trie(&encodings.louds, &encodings.trie)) {
+    trie_destroy(&encodings.trie);
+    free(words);
+    return 1;
+  }
+
+  /* change the last letter of each word to get a near miss (which is sometimes another word) */
+  char *misses = malloc((size_t) num_words * (SIZE + 1));
+  if (!misses) {
+    louds_free(&encodings.louds);
+    trie_destroy(&encodings.trie);
+    free(words);
+    return 1;
+  }
+  memcpy(misses, words, (size_t) num_words * (SIZE + 1));
+  for (uint32_t w = 0; w < num_words; w++) {
+    char *miss = misses + w * (SIZE + 1);
+    const size_t len = strlen(miss);
+    miss[len - 1] = miss[len - 1] == 'z' ? 'a' : (char) (miss[len - 1] + 1);
+  }
+
+  int has_expected = 0;
+  int expected_found = 0;
+  struct Walk expected = {0, 0};
+  for (int i = 0; i < NUM_ENCODINGS; i++) {
+    if (!selected[i]) {
+      continue;
+    }
+
+    /* look up every word and near miss */
+    int found = 0;
+    double start = now();
+    for (uint32_t w = 0; w < num_words; w++) {
+      found += ENCODINGS[i].contains(&encodings, words + w * (SIZE + 1));
+      found += ENCODINGS[i].contains(&encodings, misses + w * (SIZE + 1));
+    }
+    const double lookup_time = now() - start;
+
+    /* step to every word in each rack */
+    struct Walk walk = {0, 0};
+    start = now();
+    for (int r = 0; r < num_racks; r++) {
+      int counts[27] = {0};
+      for (int j = 0; j < SIZE; j++) {
+        counts[racks[r].letters[j] == BLANK ? 26 : racks[r].letters[j] - 'a']++;
+      }
+      ENCODINGS[i].walk(&encodings, counts, &walk);
+    }
+    const double walk_time = now() - start;
+
+    /* check against the first encoding */
+    int mismatches = 0;
+    if (!has_expected) {
+      expected_found = found;
+      expected = walk;
+      has_expected = 1;
+    } else {
+      mismatches = (found != expected_found) + (walk.steps != expected.steps) + (walk.words != expected.words);
+    }
+
+    printf("%-10s %8.1f ns/lookup  %8.1f ns/step  %d mismatches\n", ENCODINGS[i].name,
+           1e9 * lookup_time / (2.0 * num_words), 1e9 * walk_time / (double) walk.steps, mismatches);
+  }
+
+  free(misses);
+  louds_free(&encodings.louds);
+  trie_destroy(&encodings.trie);
+  free(words);
+
+  return 0;
+}
+
+
+int main(const int argc, char **argv) {
+  int num_racks;
+  unsigned int seed;
+  int selected[NUM_SOLVERS];
+  int selected_encodings[NUM_ENCODINGS];
+  if (parse_args(argc, argv, &num_racks, &seed, selected, selected_encodings)) {
+    return EXIT_FAILURE;
+  }
+
+  /* draw the racks up front, so every solver gets the same ones */
+  struct Game *racks = malloc((size_t) num_racks * sizeof(struct Game));
+  struct Game *expected = malloc((size_t) num_racks * sizeof(struct Game));
+  if (!racks || !expected || load_dictionary_tileset()) {
+    fprintf(stderr, "benchtileset: failed to set up\n");
+    free(racks);
+    free(expected);
+    return EXIT_FAILURE;
+  }
+  srand(seed);
+  for (int r = 0; r < num_racks; r++) {
+    reset_tileset(&racks[r], NULL, 0);
+  }
+
+  int has_expected = 0;
+  for (int i = 0; i < NUM_SOLVERS; i++) {
+    if (!selected[i]) {
+      continue;
+    }
+    if (set_solver_tileset(SOLVERS[i].solver) || set_histogram_backend_tileset(SOLVERS[i].backend)) {
+      printf("%-10s unavailable\n", SOLVERS[i].name);
+      continue;
+    }
+
+    /* solve every rack (warming up on the first, so one-off setup is not timed) */
+    struct Game game = racks[0];
+    search_top_words_tileset(&game);
+    int worst = 0;
+    int mismatches = 0;
+    double slowest = 0.0;
+    const double start = now();
+    for (int r = 0; r < num_racks; r++) {
+      const double rack_start = now();
+      game = racks[r];
+      search_top_words_tileset(&game);
+      const double taken = now() - rack_start;
+      if (taken > slowest) {
+        slowest = taken;
+        worst = r;
+      }
+
+      /* check against the first solver */
+      if (!has_expected) {
+        expected[r] = game;
+      } else {
+        mismatches += !same_words(&game, &expected[r]);
+      }
+    }
+    const double elapsed = now() - start;
+    has_expected = 1;
+
+    printf("%-10s %8.3f ms/rack  slowest %8.3f ms (`%s')  %d mismatches\n", SOLVERS[i].name,
+           1e3 * elapsed / num_racks, 1e3 * slowest, racks[worst].letters, mismatches);
+  }
+
+  if (bench_encodings(racks, num_racks, selected_encodings)) {
+    fprintf(stderr, "benchtileset: failed to set up the encodings\n");
+  }
+
+  free(racks);
+  free(expected);
+  free_dictionary_tileset();
+
+  return EXIT_SUCCESS;
+}
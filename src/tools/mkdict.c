@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "src/core/dict.h"
+#include "src/core/game_tileset.h"
+#include "src/core/trie.h"
+#include "src/wordlists/en-gb.h"
+
+
+/**
+ * Parse the command line arguments.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @param output Pointer to the output file path.
+ * @param binary Pointer to whether to write a dictionary file instead of a header.
+ * @param max_len Pointer to the longest word to keep (0 to keep every word).
+ * @return -1 for help text, 0 on success, non-zero on failure.
+ */
+static int parse_args(const int argc, char *argv[], const char **output, int *binary, int *max_len) {
+  static struct option long_options[] = {
+    {"help", no_argument, 0, 'h'},
+    {"binary", no_argument, 0, 'b'},
+    {"max-length", required_argument, 0, 'm'},
+    {"rack", no_argument, 0, 'r'},
+    {0, 0, 0, 0}
+  };
+
+  const char *help_text = "MKDICT: flatten the word list into a static dictionary\n"
+      "  usage: mkdict [options] OUTPUT\n"
+      "\n"
+      "  -h, --help      Display this help and exit\n"
+      "  -b, --binary    Write a dictionary file that can be memory-mapped\n"
+      "  -m, --max-length\n"
+      "                  Leave out words longer than this (such as those that\n"
+      "                  can never fit in a rack)\n"
+      "  -r, --rack      Leave out words longer than a tileset rack (the same as\n"
+      "                  --max-length with the rack size the game is built with)\n"
+      "\n"
+      "  By default OUTPUT is a C header defining the dictionary as static const data.\n";
+
+  /* parse arguments */
+  int c, opt_index;
+  int bad_option = 0;
+  *output = NULL;
+  *binary = 0;
+  *max_len = 0;
+  while ((c = getopt_long(argc, argv, "hbm:r", long_options, &opt_index)) != -1) {
+    switch (c) {
+      case 'h':
+        fprintf(stderr, "%s", help_text);
+        return -1;
+      case 'b':
+        *binary = 1;
+        break;
+      case 'm': {
+        char *endptr;
+        const long value = strtol(optarg, &endptr, 10);
+        if (endptr == optarg || *endptr != '\0' || value < 1 || value > 255) {
+          fprintf(stderr, "mkdict: invalid maximum length: `%s'\n", optarg);
+          bad_option = 1;
+        } else {
+          *max_len = (int) value;
+        }
+        break;
+      }
+      case 'r':
+        *max_len = SIZE;
+        break;
+      case '?':
+        bad_option = 1;
+        break;
+      default:
+        break;
+    }
+  }
+
+  /* check for bad options */
+  if (bad_option) {
+    fprintf(stderr, "\n%s", help_text);
+    return 1;
+  }
+
+  /* there must be exactly one output file */
+  if (optind != argc - 1) {
+    fprintf(stderr, "mkdict: expected a single output file\n");
+    fprintf(stderr, "\n%s", help_text);
+    return 2;
+  }
+  *output = argv[optind];
+
+  return 0;
+}
+
+
+/**
+ * Write the dictionary as a C header.
+ *
+ * @param dict The dictionary to write.
+ * @param longest The length of the longest word in the dictionary.
+ * @param max_len The longest word that was kept (0 if every word was kept).
+ * @param fp The file to write to.
+ * @return 0 on success, non-zero on failure.
+ */
+static int write_header(const Dict *dict, const int longest, const int max_len, FILE *fp) {
+  fprintf(fp, "// Generated by src/tools/mkdict.c from src/wordlists/en-gb.h, do not edit.\n\n");
+  fprintf(fp, "#ifndef EN_GB_DICT_H\n#define EN_GB_DICT_H\n\n");
+  fprintf(fp, "#include \"src/core/dict.h\"\n\n");
+  fprintf(fp, "#define EN_GB_DICT_MAX_LEN (%d) // the longest word in the dictionary\n", longest);
+  fprintf(fp, "#define EN_GB_DICT_LENGTH_LIMIT (%d) // longer words were left out (0 if none were)\n\n", max_len);
+
+  fprintf(fp, "static const DictNode EN_GB_NODES[%u] = {\n", dict->num_nodes);
+  for (uint32_t i = 0; i < dict->num_nodes; i++) {
+    const DictNode *node = dict->nodes + i;
+    fprintf(
+      fp, "{0x%x,%u,0x%x,%u,%u,{0}},", node->mask, node->first, node->reachable, node->min_remaining, node->max_score
+    );
+    if (i % 4 == 3 || i == dict->num_nodes - 1) {
+      fprintf(fp, "\n");
+    }
+  }
+  fprintf(fp, "};\n\n");
+
+  fprintf(fp, "static const Dict EN_GB_DICT = {EN_GB_NODES, %u, NULL, NULL, 0};\n\n", dict->num_nodes);
+  fprintf(fp, "#endif //EN_GB_DICT_H\n");
+
+  return ferror(fp);
+}
+
+
+int main(const int argc, char **argv) {
+  const char *output;
+  int binary, max_len;
+  if (parse_args(argc, argv, &output, &binary, &max_len)) {
+    return EXIT_FAILURE;
+  }
+
+  /* drop any words that are too long (which keeps the rest in order) */
+  const char **words = malloc(NUM_EN_GB * sizeof(char *));
+  if (!words) {
+    fprintf(stderr, "mkdict: out of memory\n");
+    return EXIT_FAILURE;
+  }
+  int num_words = 0;
+  int longest = 0;
+  for (int i = 0; i < NUM_EN_GB; i++) {
+    const int len = (int) strlen(EN_GB[i]);
+    if (max_len && len > max_len) {
+      continue;
+    }
+
+    words[num_words++] = EN_GB[i];
+    if (len > longest) {
+      longest = len;
+    }
+  }
+
+  /* build a minimised DAWG, so that shared suffixes are only stored once */
+  Trie root;
+  const int build_err = trie_init_dawg(&root, words, num_words);
+  free(words);
+  if (build_err == 2) {
+    fprintf(stderr, "mkdict: the word list is not sorted\n");
+    return EXIT_FAILURE;
+  } else if (build_err) {
+    fprintf(stderr, "mkdict: out of memory\n");
+    return EXIT_FAILURE;
+  }
+
+  /* flatten it into an array, bounding the score of each node with the tileset scores */
+  static const char scores[26] = LETTER_SCORES;
+  Dict dict;
+  const int err = dict_from_trie(&dict, &root, scores);
+  trie_destroy(&root);
+  if (err) {
+    fprintf(stderr, "mkdict: out of memory\n");
+    return EXIT_FAILURE;
+  }
+
+  /* write it out */
+  if (binary) {
+    if (dict_write(&dict, output)) {
+      fprintf(stderr, "mkdict: failed to write `%s'\n", output);
+      dict_free(&dict);
+      return EXIT_FAILURE;
+    }
+
+    dict_free(&dict);
+    return EXIT_SUCCESS;
+  }
+
+  FILE *fp = fopen(output, "w");
+  if (!fp) {
+    fprintf(stderr, "mkdict: could not open `%s'\n", output);
+    dict_free(&dict);
+    return EXIT_FAILURE;
+  }
+
+  int write_err = write_header(&dict, longest, max_len, fp);
+  write_err |= fclose(fp);
+  if (write_err) {
+    fprintf(stderr, "mkdict: failed to write `%s'\n", output);
+    remove(output);
+    dict_free(&dict);
+    return EXIT_FAILURE;
+  }
+
+  dict_free(&dict);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "src/core/dict.h"
+#include "src/core/game_tileset.h"
+#include "src/core/table.h"
+
+
+#define CHUNK_SIZE (1024) // number of racks each thread takes at a time
+#define MAX_WORKERS (256) // the most threads that can be used
+
+
+/**
+ * Shared state of the threads solving the racks.
+ */
+struct Batch {
+  const char *words; // every word that can be made from a rack, in alphabetical order
+  uint32_t num_words; // number of words
+  uint32_t num_racks; // number of racks to solve (the rest are left unsolved)
+  uint32_t *entries; // STORE entries for every rack
+
+  uint32_t next_rack; // the next rack to be taken by a thread
+  uint32_t num_done; // the number of racks solved so far
+};
+
+
+/**
+ * Parse the command line arguments.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @param output Pointer to the output file path.
+ * @param dict Pointer to the dictionary file to use (NULL for the built-in dictionary).
+ * @param threads Pointer to the number of threads to use.
+ * @param racks Pointer to the number of racks to solve.
+ * @return -1 for help text, 0 on success, non-zero on failure.
+ */
+static int parse_args(const int argc, char *argv[], const char **output, const char **dict, int *threads,
+                      uint32_t *racks) {
+  static struct option long_options[] = {
+    {"help", no_argument, 0, 'h'},
+    {"dict", required_argument, 0, 'd'},
+    {"threads", required_argument, 0, 'j'},
+    {"racks", required_argument, 0, 'n'},
+    {0, 0, 0, 0}
+  };
+
+  const char *help_text = "MKTABLE: find the best words for every possible rack\n"
+      "  usage: mktable [options] OUTPUT\n"
+      "\n"
+      "  -h, --help      Display this help and exit\n"
+      "  -d, --dict      Use a dictionary file instead of the built-in one\n"
+      "  -j, --threads   Set the number of threads (defaults to one per CPU core)\n"
+      "  -n, --racks     Only solve the first N racks, leaving the rest to be\n"
+      "                  searched for at runtime\n"
+      "\n"
+      "  OUTPUT is a table that can be memory-mapped by the tileset game.\n";
+
+  /* parse arguments */
+  int c, opt_index;
+  int bad_option = 0;
+  *output = NULL;
+  *dict = NULL;
+  *threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  *racks = table_num_racks();
+  while ((c = getopt_long(argc, argv, "hd:j:n:", long_options, &opt_index)) != -1) {
+    char *endptr;
+    long value;
+    switch (c) {
+      case 'h':
+        fprintf(stderr, "%s", help_text);
+        return -1;
+      case 'd':
+        *dict = optarg;
+        break;
+      case 'j':
+        value = strtol(optarg, &endptr, 10);
+        if (endptr == optarg || *endptr != '\0' || value < 1 || value > MAX_WORKERS) {
+          fprintf(stderr, "mktable: invalid number of threads: `%s'\n", optarg);
+          bad_option = 1;
+        }
+        *threads = (int) value;
+        break;
+      case 'n':
+        value = strtol(optarg, &endptr, 10);
+        if (endptr == optarg || *endptr != '\0' || value < 0) {
+          fprintf(stderr, "mktable: invalid number of racks: `%s'\n", optarg);
+          bad_option = 1;
+        }
+        if (value < (long) *racks) {
+          *racks = (uint32_t) value;
+        }
+        break;
+      case '?':
+        bad_option = 1;
+        break;
+      default:
+        break;
+    }
+  }
+
+  /* check for bad options */
+  if (bad_option) {
+    fprintf(stderr, "\n%s", help_text);
+    return 1;
+  }
+
+  /* there must be exactly one output file */
+  if (optind != argc - 1) {
+    fprintf(stderr, "mktable: expected a single output file\n");
+    fprintf(stderr, "\n%s", help_text);
+    return 2;
+  }
+  *output = argv[optind];
+
+  if (*threads < 1) {
+    *threads = 1;
+  } else if (*threads > MAX_WORKERS) {
+    *threads = MAX_WORKERS;
+  }
+
+  return 0;
+}
+
+
+/**
+ * Compare two words of the table.
+ *
+ * @param a pointer to the first word
+ * @param b pointer to the second word
+ * @return the order of the words, as for strcmp
+ */
+static int compare_words(const void *a, const void *b) {
+  return strncmp(a, b, SIZE + 1);
+}
+
+
+/**
+ * Solve a single rack.
+ *
+ * @param batch the batch of racks being solved
+ * @param rank the rank of the rack
+ */
+static void solve_rack(struct Batch *batch, const uint32_t rank) {
+  /* lay out the tiles of the rack */
+  int counts[TABLE_SYMBOLS];
+  table_unrank(rank, counts);
+
+  struct Game game;
+  memset(&game, 0, sizeof(game));
+  int n = 0;
+  for (int symbol = 0; symbol < TABLE_SYMBOLS; symbol++) {
+    for (int c = 0; c < counts[symbol]; c++) {
+      game.letters[n++] = symbol == 26 ? BLANK : (char) ('a' + symbol);
+    }
+  }
+
+  search_top_words_tileset(&game);
+
+  /* store each word as its position in the list of words */
+  uint32_t *entries = batch->entries + (size_t) rank * STORE;
+  for (int i = 0; i < STORE; i++) {
+    if (game.top_words[i][0] == '\0') {
+      entries[i] = TABLE_ENTRY(TABLE_NO_WORD, 0);
+      continue;
+    }
+
+    const char *word = bsearch(game.top_words[i], batch->words, batch->num_words, SIZE + 1, compare_words);
+    entries[i] = TABLE_ENTRY((uint32_t) (word - batch->words) / (SIZE + 1), game.top_scores[i]);
+  }
+}
+
+
+/**
+ * Solve chunks of racks until there are none left.
+ *
+ * @param arg pointer to the batch
+ * @return NULL
+ */
+static void *solve_worker(void *arg) {
+  struct Batch *batch = arg;
+
+  while (1) {
+    const uint32_t first = __atomic_fetch_add(&batch->next_rack, CHUNK_SIZE, __ATOMIC_RELAXED);
+    if (first >= batch->num_racks) {
+      break;
+    }
+
+    const uint32_t last = first + CHUNK_SIZE < batch->num_racks ? first + CHUNK_SIZE : batch->num_racks;
+    for (uint32_t rank = first; rank < last; rank++) {
+      solve_rack(batch, rank);
+    }
+
+    const uint32_t done = __atomic_add_fetch(&batch->num_done, last - first, __ATOMIC_RELAXED);
+    if (done / (64 * CHUNK_SIZE) != (done - (last - first)) / (64 * CHUNK_SIZE)) {
+      fprintf(stderr, "mktable: solved %u of %u racks\n", done, batch->num_racks);
+    }
+  }
+
+  return NULL;
+}
+
+
+int main(const int argc, char **argv) {
+  const char *output, *dict_path;
+  int threads;
+  uint32_t racks;
+  if (parse_args(argc, argv, &output, &dict_path, &threads, &racks)) {
+    return EXIT_FAILURE;
+  }
+
+  /* use the same dictionary as the game will */
+  if (dict_path && open_dictionary_tileset(dict_path)) {
+    fprintf(stderr, "mktable: failed to open dictionary `%s'\n", dict_path);
+    return EXIT_FAILURE;
+  }
+  const Dict *dict = dictionary_tileset();
+  if (!dict) {
+    fprintf(stderr, "mktable: failed to load dictionary\n");
+    return EXIT_FAILURE;
+  }
+
+  /* only words that fit in a rack can be best words */
+  struct Batch batch;
+  memset(&batch, 0, sizeof(batch));
+  char *words;
+  if (dict_list_words(dict, SIZE, &words, &batch.num_words)) {
+    fprintf(stderr, "mktable: out of memory\n");
+    free_dictionary_tileset();
+    return EXIT_FAILURE;
+  }
+  batch.words = words;
+  batch.num_racks = racks;
+
+  const size_t num_entries = (size_t) table_num_racks() * STORE;
+  batch.entries = malloc(num_entries * sizeof(uint32_t));
+  if (!batch.entries) {
+    fprintf(stderr, "mktable: out of memory\n");
+    free(words);
+    free_dictionary_tileset();
+    return EXIT_FAILURE;
+  }
+  for (size_t i = (size_t) racks * STORE; i < num_entries; i++) {
+    batch.entries[i] = TABLE_UNSOLVED;
+  }
+
+  /* solve the racks, with this thread working too */
+  pthread_t workers[MAX_WORKERS];
+  int started[MAX_WORKERS] = {0};
+  for (int t = 1; t < threads; t++) {
+    started[t] = !pthread_create(&workers[t], NULL, solve_worker, &batch);
+  }
+  solve_worker(&batch);
+  for (int t = 1; t < threads; t++) {
+    if (started[t]) {
+      pthread_join(workers[t], NULL);
+    }
+  }
+
+  const int err = table_write(output, dict_checksum(dict), words, batch.num_words, batch.entries);
+  if (err) {
+    fprintf(stderr, "mktable: failed to write `%s'\n", output);
+  }
+
+  free(batch.entries);
+  free(words);
+  free_dictionary_tileset();
+
+  return err ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,447 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "src/core/ai_2048.h"
+#include "src/core/game_2048.h"
+
+
+#define MAX_WORKERS (256) // the most threads that can be used
+#define MAX_TILE (32) // the most tile exponents counted in the results (far beyond any reachable tile)
+
+
+/**
+ * Ways of choosing each move.
+ */
+typedef enum Policy {
+  POLICY_RANDOM, // any move that does something
+  POLICY_GREEDY, // the move that scores the most straight away
+  POLICY_EXPECTIMAX, // the move found by the expectimax search
+} Policy;
+
+
+// Names of the policies on the command line, in the same order
+static const char *POLICY_NAMES[] = {"random", "greedy", "expectimax"};
+
+#define NUM_POLICIES ((int) (sizeof(POLICY_NAMES) / sizeof(POLICY_NAMES[0])))
+
+
+/**
+ * Result of a single game.
+ */
+struct Outcome {
+  int score; // final score
+  int moves; // number of moves played
+  int max_tile; // exponent of the biggest tile
+  long depth_sum; // total depth of every expectimax search (0 for the other policies)
+  long long nodes; // total positions visited by every expectimax search
+};
+
+
+/**
+ * Shared state of the threads playing the games.
+ */
+struct Batch {
+  Policy policy; // how each move is chosen
+  long budget_us; // time the expectimax search may take for each move
+  int search_threads; // threads used by each expectimax search (including the thread playing the game)
+  uint64_t seed; // seed of the first game (each game uses the next seed)
+  int num_games; // number of games to play
+  struct Outcome *outcomes; // the result of each game
+
+  int next_game; // the next game to be taken by a thread
+  int failed; // set if a thread could not set up its search
+};
+
+
+/**
+ * Parse the command line arguments.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @param batch Set to the games to play.
+ * @param threads Pointer to the number of threads to use.
+ * @return -1 for help text, 0 on success, non-zero on failure.
+ */
+static int parse_args(const int argc, char *argv[], struct Batch *batch, int *threads) {
+  static struct option long_options[] = {
+    {"help", no_argument, 0, 'h'},
+    {"budget", required_argument, 0, 'b'},
+    {"threads", required_argument, 0, 'j'},
+    {"games", required_argument, 0, 'n'},
+    {"policy", required_argument, 0, 'p'},
+    {"seed", required_argument, 0, 's'},
+    {"search-threads", required_argument, 0, 't'},
+    {0, 0, 0, 0}
+  };
+
+  const char *help_text = "SIM2048: play games of 2048 without a display and summarise the results\n"
+      "  usage: sim2048 [options]\n"
+      "\n"
+      "  -h, --help      Display this help and exit\n"
+      "  -b, --budget    Set the time the expectimax policy may take for each\n"
+      "                  move, in microseconds (defaults to 1000)\n"
+      "  -j, --threads   Set the number of threads (defaults to one per CPU core)\n"
+      "  -n, --games     Set the number of games to play (defaults to 1000)\n"
+      "  -p, --policy    Choose each move with one of: random (the default),\n"
+      "                  greedy (the most points straight away) or expectimax\n"
+      "  -s, --seed      Set the seed of the first game (defaults to 1)\n"
+      "  -t, --search-threads\n"
+      "                  Set the number of threads used by each expectimax\n"
+      "                  search (defaults to 1, 0 for one per CPU core)\n"
+      "\n"
+      "  Game i uses seed + i, so the random and greedy policies always give\n"
+      "  the same results for the same options, however many threads are used.\n";
+
+  /* parse arguments */
+  int c, opt_index;
+  int bad_option = 0;
+  memset(batch, 0, sizeof(struct Batch));
+  batch->policy = POLICY_RANDOM;
+  batch->budget_us = 1000;
+  batch->seed = 1;
+  batch->num_games = 1000;
+  batch->search_threads = 1;
+  *threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  while ((c = getopt_long(argc, argv, "hb:j:n:p:s:t:", long_options, &opt_index)) != -1) {
+    char *endptr;
+    long value;
+    switch (c) {
+      case 'h':
+        fprintf(stderr, "%s", help_text);
+        return -1;
+      case 'b':
+        value = strtol(optarg, &endptr, 10);
+        if (endptr == optarg || *endptr != '\0' || value < 0) {
+          fprintf(stderr, "sim2048: invalid budget: `%s'\n", optarg);
+          bad_option = 1;
+        }
+        batch->budget_us = value;
+        break;
+      case 'j':
+        value = strtol(optarg, &endptr, 10);
+        if (endptr == optarg || *endptr != '\0' || value < 1 || value > MAX_WORKERS) {
+          fprintf(stderr, "sim2048: invalid number of threads: `%s'\n", optarg);
+          bad_option = 1;
+        }
+        *threads = (int) value;
+        break;
+      case 'n':
+        value = strtol(optarg, &endptr, 10);
+        if (endptr == optarg || *endptr != '\0' || value < 1 || value > 100000000) {
+          fprintf(stderr, "sim2048: invalid number of games: `%s'\n", optarg);
+          bad_option = 1;
+        }
+        batch->num_games = (int) value;
+        break;
+      case 'p': {
+        int found = 0;
+        for (int p = 0; p < NUM_POLICIES; p++) {
+          if (strcmp(optarg, POLICY_NAMES[p]) == 0) {
+            batch->policy = (Policy) p;
+            found = 1;
+          }
+        }
+        if (!found) {
+          fprintf(stderr, "sim2048: unknown policy: `%s'\n", optarg);
+          bad_option = 1;
+        }
+        break;
+      }
+      case 's':
+        batch->seed = strtoull(optarg, &endptr, 0);
+        if (endptr == optarg || *endptr != '\0') {
+          fprintf(stderr, "sim2048: invalid seed: `%s'\n", optarg);
+          bad_option = 1;
+        }
+        break;
+      case 't':
+        value = strtol(optarg, &endptr, 10);
+        if (endptr == optarg || *endptr != '\0' || value < 0 || value > AI_MAX_THREADS) {
+          fprintf(stderr, "sim2048: invalid number of search threads: `%s'\n", optarg);
+          bad_option = 1;
+        }
+        batch->search_threads = (int) value;
+        break;
+      case '?':
+        bad_option = 1;
+        break;
+      default:
+        break;
+    }
+  }
+
+  /* check for bad options */
+  if (bad_option || optind != argc) {
+    fprintf(stderr, "\n%s", help_text);
+    return 1;
+  }
+
+  if (*threads < 1) {
+    *threads = 1;
+  } else if (*threads > MAX_WORKERS) {
+    *threads = MAX_WORKERS;
+  }
+  if (batch->search_threads == 0) {
+    const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    batch->search_threads = cores < 1 ? 1 : cores > AI_MAX_THREADS ? AI_MAX_THREADS : (int) cores;
+  }
+
+  return 0;
+}
+
+
+/**
+ * Get the time from a monotonic clock.
+ *
+ * @return the time in seconds
+ */
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+
+/**
+ * Choose the move that scores the most points straight away.
+ *
+ * Ties (such as when nothing merges) go to the move that leaves the most empty cells, then to the first move.
+ *
+ * @param game the game state
+ * @return the move
+ */
+static Move greedy_move(const struct Game *game) {
+  Move best = UP;
+  int best_score = -1, best_empty = -1;
+  for (int m = 0; m < 4; m++) {
+    struct Game copy = *game;
+    if (move_2048(&copy, (Move) m) != MOVE_SUCCESS) {
+      continue;
+    }
+
+    const int score = copy.score - game->score;
+    if (score > best_score || (score == best_score && copy.nz > best_empty)) {
+      best = (Move) m;
+      best_score = score;
+      best_empty = copy.nz;
+    }
+  }
+
+  return best;
+}
+
+
+/**
+ * Play a single game to the end.
+ *
+ * @param batch the games being played
+ * @param ai the search used by the expectimax policy (NULL for the other policies)
+ * @param index the index of the game
+ */
+static void play_game(struct Batch *batch, struct Ai *ai, const int index) {
+  struct Game game;
+  reset_seeded_2048(&game, batch->seed + (uint64_t) index);
+
+  /* the random policy draws its moves from a generator of its own, so the tiles follow the seed */
+  uint64_t rng = (batch->seed + (uint64_t) index) * 0xBF58476D1CE4E5B9ull | 1;
+
+  int moves = 0;
+  long depth_sum = 0;
+  long long nodes = 0;
+  while (game.status == PLAYING) {
+    Move move = UP;
+    switch (batch->policy) {
+      case POLICY_RANDOM:
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        move = (Move) ((rng >> 32) % 4);
+        break;
+      case POLICY_GREEDY:
+        move = greedy_move(&game);
+        break;
+      case POLICY_EXPECTIMAX: {
+        if (best_move_2048(ai, &game, batch->budget_us, &move)) {
+          game.status = LOST; // cannot happen while the game is still being played
+          continue;
+        }
+        int depth;
+        long search_nodes;
+        stats_ai_2048(ai, &depth, &search_nodes);
+        depth_sum += depth;
+        nodes += search_nodes;
+        break;
+      }
+    }
+
+    // moves that do nothing are tried again (only the random policy makes them)
+    if (turn_2048(&game, move) != MOVE_ERROR) {
+      moves++;
+    }
+  }
+
+  struct Outcome *outcome = &batch->outcomes[index];
+  outcome->score = game.score;
+  outcome->moves = moves;
+  outcome->depth_sum = depth_sum;
+  outcome->nodes = nodes;
+  outcome->max_tile = 0;
+  for (int i = 0; i < SIZE * SIZE; i++) {
+    if (game.grid[i] > outcome->max_tile) {
+      outcome->max_tile = game.grid[i];
+    }
+  }
+}
+
+
+/**
+ * Play games until there are none left.
+ *
+ * @param arg pointer to the batch
+ * @return NULL
+ */
+static void *play_worker(void *arg) {
+  struct Batch *batch = arg;
+
+  /* each thread has a search of its own (with its own threads, if it uses more than one) */
+  struct Ai *ai = NULL;
+  if (batch->policy == POLICY_EXPECTIMAX) {
+    ai = start_ai_2048();
+    if (!ai) {
+      __atomic_store_n(&batch->failed, 1, __ATOMIC_RELAXED);
+      return NULL;
+    }
+    set_threads_ai_2048(ai, batch->search_threads);
+  }
+
+  while (1) {
+    const int index = __atomic_fetch_add(&batch->next_game, 1, __ATOMIC_RELAXED);
+    if (index >= batch->num_games) {
+      break;
+    }
+
+    play_game(batch, ai, index);
+  }
+
+  free_ai_2048(ai);
+  return NULL;
+}
+
+
+/**
+ * Compare the scores of two games.
+ *
+ * @param a pointer to the first game's outcome
+ * @param b pointer to the second game's outcome
+ * @return the order of the scores, lowest first
+ */
+static int compare_scores(const void *a, const void *b) {
+  const int score_a = ((const struct Outcome *) a)->score;
+  const int score_b = ((const struct Outcome *) b)->score;
+  return (score_a > score_b) - (score_a < score_b);
+}
+
+
+/**
+ * Print a summary of the games.
+ *
+ * @param batch the games that were played, whose outcomes are sorted by score
+ * @param threads the number of threads used
+ * @param elapsed the time taken to play the games, in seconds
+ */
+static void report(struct Batch *batch, const int threads, const double elapsed) {
+  const int n = batch->num_games;
+
+  long long total_moves = 0, total_nodes = 0;
+  long total_depth = 0;
+  double total_score = 0.0;
+  int tile_counts[MAX_TILE + 1] = {0};
+  for (int g = 0; g < n; g++) {
+    total_moves += batch->outcomes[g].moves;
+    total_score += batch->outcomes[g].score;
+    total_depth += batch->outcomes[g].depth_sum;
+    total_nodes += batch->outcomes[g].nodes;
+    tile_counts[batch->outcomes[g].max_tile < MAX_TILE ? batch->outcomes[g].max_tile : MAX_TILE]++;
+  }
+
+  printf("policy      %s", POLICY_NAMES[batch->policy]);
+  if (batch->policy == POLICY_EXPECTIMAX) {
+    printf(" (%ld us per move, %d thread%s per search)", batch->budget_us, batch->search_threads,
+           batch->search_threads == 1 ? "" : "s");
+  }
+  printf("\n");
+  printf("games       %d on %d thread%s in %.3f s\n", n, threads, threads == 1 ? "" : "s", elapsed);
+  printf("throughput  %.1f games/s, %.0f moves/s\n", n / elapsed, (double) total_moves / elapsed);
+  printf("moves       %.1f per game\n", (double) total_moves / n);
+  if (batch->policy == POLICY_EXPECTIMAX) {
+    printf("search      %.2f moves deep on average, %.0f positions/s\n", (double) total_depth / (double) total_moves,
+           (double) total_nodes / elapsed);
+  }
+
+  /* percentiles are taken from the sorted scores (by nearest rank) */
+  qsort(batch->outcomes, (size_t) n, sizeof(struct Outcome), compare_scores);
+  static const int PERCENTILES[] = {1, 10, 25, 50, 75, 90, 99};
+  printf("\nscore       mean %.0f, min %d, max %d\n", total_score / n, batch->outcomes[0].score,
+         batch->outcomes[n - 1].score);
+  for (size_t p = 0; p < sizeof(PERCENTILES) / sizeof(PERCENTILES[0]); p++) {
+    const int rank = (int) (((long long) PERCENTILES[p] * n + 99) / 100);
+    printf("  p%-3d      %d\n", PERCENTILES[p], batch->outcomes[rank > 0 ? rank - 1 : 0].score);
+  }
+
+  /* the share of games ending on each biggest tile, and reaching at least that tile */
+  printf("\nmax tile    games     share   reached\n");
+  int reached = n;
+  for (int e = 1; e <= MAX_TILE; e++) {
+    if (tile_counts[e]) {
+      printf("  %-8lld  %-8d  %5.1f%%  %5.1f%%\n", 1ll << e, tile_counts[e], 100.0 * tile_counts[e] / n,
+             100.0 * reached / n);
+    }
+    reached -= tile_counts[e];
+  }
+}
+
+
+int main(const int argc, char **argv) {
+  struct Batch batch;
+  int threads;
+  if (parse_args(argc, argv, &batch, &threads)) {
+    return EXIT_FAILURE;
+  }
+
+  batch.outcomes = calloc((size_t) batch.num_games, sizeof(struct Outcome));
+  if (!batch.outcomes) {
+    fprintf(stderr, "sim2048: out of memory\n");
+    return EXIT_FAILURE;
+  }
+
+  /* play the games, with this thread working too */
+  const double start = now_s();
+  pthread_t workers[MAX_WORKERS];
+  int started[MAX_WORKERS] = {0};
+  for (int t = 1; t < threads; t++) {
+    started[t] = !pthread_create(&workers[t], NULL, play_worker, &batch);
+  }
+  play_worker(&batch);
+  for (int t = 1; t < threads; t++) {
+    if (started[t]) {
+      pthread_join(workers[t], NULL);
+    }
+  }
+  const double elapsed = now_s() - start;
+
+  if (batch.failed) {
+    fprintf(stderr, "sim2048: out of memory\n");
+    free(batch.outcomes);
+    return EXIT_FAILURE;
+  }
+
+  report(&batch, threads, elapsed);
+  free(batch.outcomes);
+
+  return EXIT_SUCCESS;
+}